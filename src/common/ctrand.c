@@ -0,0 +1,79 @@
+#ifndef lint
+static const char	RCSid[] = "$Id$";
+#endif
+/*
+ * Counter-based random numbers (Philox4x32-10, Salmon et al. 2011)
+ *
+ *  Unlike random(3), these keep no hidden state.  Each value is a pure
+ *  function of a key and a counter, so independent streams can be
+ *  drawn in any order, by any process, with identical results.
+ */
+
+#include "copyright.h"
+
+#include  "random.h"
+
+#define PHILOX_M0	0xD2511F53U	/* round multipliers */
+#define PHILOX_M1	0xCD9E8D57U
+#define PHILOX_W0	0x9E3779B9U	/* key schedule (Weyl) */
+#define PHILOX_W1	0xBB67AE85U
+
+#define PHILOX_NR	10		/* number of rounds */
+
+#define lo32(l)		((unsigned)((l) & 0xffffffff))
+#define hi32(l)		((unsigned)((l) >> 16 >> 16 & 0xffffffff))
+
+
+static void
+philox4x32(			/* encrypt counter in place */
+	unsigned  x[4],
+	unsigned long  key
+)
+{
+	unsigned	k0 = lo32(key), k1 = hi32(key);
+	unsigned long long	p0, p1;
+	int		i;
+
+	for (i = PHILOX_NR; i--; ) {
+		p0 = (unsigned long long)PHILOX_M0 * x[0];
+		p1 = (unsigned long long)PHILOX_M1 * x[2];
+		x[0] = hi32(p1) ^ x[1] ^ k0;
+		x[1] = lo32(p1);
+		x[2] = hi32(p0) ^ x[3] ^ k1;
+		x[3] = lo32(p0);
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+}
+
+
+double
+ctrandom(			/* uniform in [0,1) for key and counter */
+	unsigned long  key,
+	unsigned long  ctr
+)
+{
+	unsigned	x[4];
+
+	x[0] = lo32(ctr); x[1] = hi32(ctr);
+	x[2] = x[3] = 0;
+	philox4x32(x, key);
+					/* 53 significant bits */
+	return(((x[0]>>5)*67108864. + (x[1]>>6)) * (1./9007199254740992.));
+}
+
+
+unsigned long
+ctrhash(			/* derive a new stream key */
+	unsigned long  key,
+	unsigned long  ctr
+)
+{
+	unsigned	x[4];
+
+	x[0] = lo32(ctr); x[1] = hi32(ctr);
+	x[2] = 1; x[3] = 0;		/* disjoint from ctrandom() */
+	philox4x32(x, key);
+
+	return((unsigned long)x[2] << 16 << 16 | x[3]);
+}
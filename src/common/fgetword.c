@@ -10,9 +10,18 @@ static const char	RCSid[] = "$Id: fgetword.c,v 2.8 2017/08/10 19:10:44 greg Exp
 #include "copyright.h"
 
 #include  "rtio.h"
+#include  "platform.h"
 
 #include  <ctype.h>
 
+#ifdef getc_unlocked		/* lock once per word, not per character */
+#undef getc
+#define getc	getc_unlocked
+#else
+#define flockfile(fp)
+#define funlockfile(fp)
+#endif
+
 
 char *
 fgetword(			/* get (quoted) word up to n-1 characters */
@@ -27,6 +36,7 @@ fgetword(			/* get (quoted) word up to n-1 characters */
 					/* sanity checks */
 	if ((s == NULL) | (n < 2))
 		return(NULL);
+	flockfile(fp);
 					/* skip initial white space */
 	do
 		c = getc(fp);
@@ -45,10 +55,10 @@ fgetword(			/* get (quoted) word up to n-1 characters */
 		c = getc(fp);
 	}
 	*cp = '\0';
-	if (c == EOF) {			/* hit end-of-file? */
-		if (cp == s)		/* and got nothing? */
-			return(NULL);
-	} else if (!quote)		/* replace white character */
+	if (c != EOF && !quote)		/* replace white character */
 		ungetc(c, fp);
+	funlockfile(fp);
+	if ((c == EOF) & (cp == s))	/* hit end-of-file and got nothing? */
+		return(NULL);
 	return(s);
 }
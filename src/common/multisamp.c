@@ -18,6 +18,17 @@ multisamp(t, n, r)	/* convert 1-dimensional sample to N dimensions */
 double	t[];			/* returned N-dimensional vector */
 register int	n;		/* number of dimensions */
 double	r;			/* 1-dimensional sample [0,1) */
+{
+	multisampj(t, n, r, NULL);
+}
+
+
+void
+multisampj(t, n, r, jit)	/* multisamp() with given low-order jitter */
+double	t[];			/* returned N-dimensional vector */
+register int	n;		/* number of dimensions */
+double	r;			/* 1-dimensional sample [0,1) */
+const double	jit[];		/* N values in [0,1), or NULL for random */
 {
 	int	j;
 	register int	i, k;
@@ -37,5 +48,5 @@ double	r;			/* 1-dimensional sample [0,1) */
 	}
 	i = n;
 	while (i-- > 0)
-		t[i] = 1./256. * (ti[i] + frandom());
+		t[i] = 1./256. * (ti[i] + (jit != NULL ? jit[i] : frandom()));
 }
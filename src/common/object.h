@@ -81,6 +81,18 @@ extern OBJECT  nobjects;		/* # of objects */
 
 #define  MAXSET		511		/* maximum object set size */
 
+/*
+ *     Binary scene files carry the same objects and commands as text
+ *  scene files in a form that loads faster.  The reader calls back
+ *  with each object and its modifier name, or with a command and NULL.
+ *  It returns 0 if the "#?" line turns out to be an ordinary comment.
+ */
+
+#define  SCENEFMT	"Radiance_scene"	/* binary scene format */
+#define  BSCMAGIC	0x5c01		/* magic number (with version) */
+
+typedef void bsc_cbfunc(char *mod, OBJREC *o);
+
 #define setfree(os)	free((void *)(os))
 
 extern void  (*addobjnotify[])();        /* people to notify of new objects */
@@ -104,6 +116,7 @@ extern OBJECT *	setsave(OBJECT *os);
 extern void	setunion(OBJECT *osr, OBJECT *os1, OBJECT *os2);
 extern void	setintersect(OBJECT *osr, OBJECT *os1, OBJECT *os2);
 extern OCTREE	fullnode(OBJECT *oset);
+extern const OBJECT *	objsetp(OCTREE ot);
 extern void	objset(OBJECT *oset, OCTREE ot);
 extern int	dosets(int (*f)());
 extern void	donesets(void);
@@ -116,9 +129,15 @@ extern int	readfargs(FUNARGS *fa, FILE *fp);
 extern void	freefargs(FUNARGS *fa);
 					/* defined in readobj.c */
 extern void	readobj(char *inpspec);
+extern void	spoolobj(char *inpspec[], int n, int nproc);
 extern void	getobject(char *name, FILE *fp);
 extern OBJECT	newobject(void);
 extern void	freeobjects(int firstobj, int nobjs);
+					/* defined in sceneio.c */
+extern void	beginbscene(FILE *fp);
+extern void	putbscene(char *mod, OBJREC *o, FILE *fp);
+extern void	endbscene(FILE *fp);
+extern int	readbscene(char *name, FILE *fp, bsc_cbfunc *f);
 					/* defined in free_os.c */
 extern int	free_os(OBJREC *op);
 
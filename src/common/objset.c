@@ -256,9 +256,8 @@ memerr:
 }
 
 
-void
-objset(			/* get object set for full node */
-	OBJECT  *oset,
+const OBJECT *
+objsetp(			/* point to object set for full node */
 	OCTREE  ot
 )
 {
@@ -273,11 +272,24 @@ objset(			/* get object set for full node */
 	for (i = ot/OSTSIZ; i--; os += *os + 1)
 		if (*os <= 0)
 			goto noderr;
-	for (i = *os; i-- >= 0; )		/* copy set here */
-		*oset++ = *os++;
-	return;
+	return(os);			/* valid until next fullnode() */
 noderr:
 	error(CONSISTENCY, "bad node in objset");
+	return(NULL);	/* pro forma return */
+}
+
+
+void
+objset(			/* get object set for full node */
+	OBJECT  *oset,
+	OCTREE  ot
+)
+{
+	const OBJECT  *os = objsetp(ot);
+	int  i;
+
+	for (i = *os; i-- >= 0; )		/* copy set here */
+		*oset++ = *os++;
 }
 
 
@@ -91,6 +91,11 @@
 	#include <unistd.h>
     #define RHAS_STAT
     #define RHAS_FORK_EXEC
+    #include <stdio.h>
+    #if defined(_POSIX_THREAD_SAFE_FUNCTIONS) && !defined(getc_unlocked)
+      /* a function in glibc, so let #ifdef getc_unlocked find it */
+      #define getc_unlocked getc_unlocked
+    #endif
   #endif
 
   /* everybody except Windows */
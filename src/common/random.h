@@ -43,6 +43,10 @@ extern int	ilhash(int *d, int n);
 extern int	urind(int s, int i);
 				/* defined in multisamp.c */
 extern void	multisamp(double t[], int n, double r);
+extern void	multisampj(double t[], int n, double r, const double jit[]);
+				/* defined in ctrand.c */
+extern double	ctrandom(unsigned long key, unsigned long ctr);
+extern unsigned long	ctrhash(unsigned long key, unsigned long ctr);
 
 
 #ifdef __cplusplus
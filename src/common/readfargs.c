@@ -21,8 +21,9 @@ readfargs(			/* read function arguments from stream */
 {
 #define getstr(s)	(fgetword(s,sizeof(s),fp)!=NULL)
 #define getint(s)	(getstr(s) && isint(s))
-#define getflt(s)	(getstr(s) && isflt(s))
+#define getflt(s,d)	(getstr(s) && fltcvt(s,&(d)))
 	char  sbuf[MAXSTR];
+	double  d;
 	int  n, i;
 
 	if (!getint(sbuf) || (n = atoi(sbuf)) < 0)
@@ -63,9 +64,9 @@ readfargs(			/* read function arguments from stream */
 		if (fa->farg == NULL)
 			return(-1);
 		for (i = 0; i < n; i++) {
-			if (!getflt(sbuf))
+			if (!getflt(sbuf, d))
 				return(0);
-			fa->farg[i] = atof(sbuf);
+			fa->farg[i] = d;
 		}
 	} else
 		fa->farg = NULL;
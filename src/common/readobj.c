@@ -19,10 +19,115 @@ static const char RCSid[] = "$Id: readobj.c,v 2.23 2019/05/04 00:36:58 greg Exp
 #include  "object.h"
 #include  "otypes.h"
 
+#ifdef RHAS_FORK_EXEC
+#include  <sys/wait.h>
+#endif
+
+#ifdef getc_unlocked		/* avoid per-character locking */
+#undef getc
+#define getc	getc_unlocked
+#else
+#define flockfile(fp)
+#define funlockfile(fp)
+#endif
+
 
 OBJREC  *objblock[MAXOBJBLK];		/* our objects */
 OBJECT  nobjects = 0;			/* # of objects */
 
+static struct spool {
+	char	*spec;			/* command to run */
+	FILE	*fp;			/* its spooled output */
+	int	pid;			/* process if running */
+}	*spool = NULL;			/* scene commands run ahead */
+static int  nspool = 0;			/* # spooled commands */
+static int  nspstarted = 0;		/* # started so far */
+static int  nsprunning = 0;		/* # still running */
+static int  nspmax = 1;			/* maximum running at once */
+
+static char  *bscname = NULL;		/* binary scene being read */
+
+#define	OALIAS	-2			/* "inherit" modifier */
+
+static void  getbscobj(char *mod, OBJREC *o);
+
+
+static void
+startspool(void)			/* start next spooled command */
+{
+#ifdef RHAS_FORK_EXEC
+	struct spool  *sp = spool + nspstarted;
+
+	if ((sp->fp = tmpfile()) == NULL)
+		error(SYSTEM, "cannot create spool file");
+	if ((sp->pid = fork()) < 0) {
+		sprintf(errmsg, "cannot execute \"%s\"", sp->spec);
+		error(SYSTEM, errmsg);
+	}
+	if (!sp->pid) {			/* child runs command into file */
+		dup2(fileno(sp->fp), 1);
+		execl("/bin/sh", "sh", "-c", sp->spec+1, (char *)NULL);
+		_exit(127);
+	}
+	nspstarted++;
+	nsprunning++;
+#endif
+}
+
+
+static FILE *
+getspool(				/* get spooled output for command */
+	char  *inpspec
+)
+{
+	int  i;
+
+	for (i = 0; i < nspool; i++)
+		if (spool[i].spec != NULL && !strcmp(spool[i].spec, inpspec))
+			break;
+	if (i >= nspool)
+		return(NULL);
+	while (i >= nspstarted)		/* out of order, catch up */
+		startspool();
+#ifdef RHAS_FORK_EXEC
+	if (spool[i].pid > 0) {		/* wait for it to finish */
+		waitpid(spool[i].pid, NULL, 0);
+		spool[i].pid = 0;
+		nsprunning--;
+	}
+#endif
+	while (nsprunning < nspmax && nspstarted < nspool)
+		startspool();		/* keep others going */
+	spool[i].spec = NULL;		/* each is read once */
+	rewind(spool[i].fp);
+	return(spool[i].fp);
+}
+
+
+void
+spoolobj(				/* run scene commands ahead of reading */
+	char  *inpspec[],
+	int  n,
+	int  nproc
+)
+{
+#ifdef RHAS_FORK_EXEC
+	int  i;
+
+	if (nproc <= 1 || spool != NULL)
+		return;
+	spool = (struct spool *)calloc(n, sizeof(struct spool));
+	if (spool == NULL)
+		error(SYSTEM, "out of memory in spoolobj");
+	for (i = 0; i < n; i++)
+		if (inpspec[i] != NULL && inpspec[i][0] == '!')
+			spool[nspool++].spec = inpspec[i];
+	nspmax = nproc;
+	while (nsprunning < nspmax && nspstarted < nspool)
+		startspool();
+#endif
+}
+
 
 void
 readobj(				/* read in an object file or stream */
@@ -31,6 +136,7 @@ readobj(				/* read in an object file or stream */
 {
 	OBJECT  lastobj;
 	FILE  *infp;
+	int  spooled = 0;
 	char  buf[2048];
 	int  c;
 
@@ -39,7 +145,9 @@ readobj(				/* read in an object file or stream */
 		infp = stdin;
 		inpspec = "standard input";
 	} else if (inpspec[0] == '!') {
-		if ((infp = popen(inpspec+1, "r")) == NULL) {
+		if (nspool && (infp = getspool(inpspec)) != NULL)
+			spooled = 1;
+		else if ((infp = popen(inpspec+1, "r")) == NULL) {
 			sprintf(errmsg, "cannot execute \"%s\"", inpspec);
 			error(SYSTEM, errmsg);
 		}
@@ -47,6 +155,17 @@ readobj(				/* read in an object file or stream */
 		sprintf(errmsg, "cannot open scene file \"%s\"", inpspec);
 		error(SYSTEM, errmsg);
 	}
+	flockfile(infp);
+	if ((c = getc(infp)) == '#') {
+		if ((c = getc(infp)) == '?') {	/* binary scene */
+			char  *oldname = bscname;
+			bscname = inpspec;
+			readbscene(inpspec, infp, getbscobj);
+			bscname = oldname;
+		} else if (c != '\n')		/* comment */
+			fgets(buf, sizeof(buf), infp);
+	} else if (c != EOF)
+		ungetc(c, infp);
 	while ((c = getc(infp)) != EOF) {
 		if (isspace(c))
 			continue;
@@ -61,7 +180,10 @@ readobj(				/* read in an object file or stream */
 			getobject(inpspec, infp);
 		}
 	}
-	if (inpspec[0] == '!')
+	funlockfile(infp);
+	if (spooled)
+		fclose(infp);
+	else if (inpspec[0] == '!')
 		pclose(infp);
 	else if (infp != stdin)
 		fclose(infp);
@@ -72,13 +194,115 @@ readobj(				/* read in an object file or stream */
 }
 
 
+static OBJECT
+getmodifier(				/* get modifier by name */
+	char  *name,
+	char  *mod
+)
+{
+	OBJECT  omod;
+
+	if (strchr(mod, '\t')) {
+		sprintf(errmsg, "(%s): illegal tab in modifier \"%s\"",
+					name, mod);
+		error(USER, errmsg);
+	}
+	if (!strcmp(mod, VOIDID))
+		return(OVOID);
+	if (!strcmp(mod, ALIASMOD))
+		return(OALIAS);
+	if ((omod = modifier(mod)) == OVOID) {
+		sprintf(errmsg, "(%s): undefined modifier \"%s\"", name, mod);
+		error(USER, errmsg);
+	}
+	return(omod);
+}
+
+
+static void
+setalias(				/* make object an alias of reference */
+	char  *name,
+	OBJREC  *objp,
+	char  *ref
+)
+{
+	OBJECT  alias;
+
+	if ((alias = modifier(ref)) == OVOID) {
+		sprintf(errmsg, "(%s): bad reference \"%s\"", name, ref);
+		objerror(objp, USER, errmsg);
+	}
+	if (objp->omod == OALIAS || 
+			objp->omod == objptr(alias)->omod) {
+		objp->omod = alias;
+	} else {
+		objp->oargs.sarg = (char **)malloc(sizeof(char *));
+		if (objp->oargs.sarg == NULL)
+			error(SYSTEM, "out of memory in setalias");
+		objp->oargs.nsargs = 1;
+		objp->oargs.sarg[0] = savestr(ref);
+	}
+}
+
+
+static void
+endobject(				/* check and insert new object */
+	char  *name,
+	OBJECT  obj
+)
+{
+	OBJREC  *objp = objptr(obj);
+
+	if (objp->omod == OALIAS) {
+		sprintf(errmsg, "(%s): inappropriate use of '%s' modifier",
+				name, ALIASMOD);
+		objerror(objp, USER, errmsg);
+	}
+					/* initialize */
+	objp->os = NULL;
+
+	insertobject(obj);		/* add to global structure */
+}
+
+
+static void
+getbscobj(				/* add object from binary scene */
+	char  *mod,
+	OBJREC  *o
+)
+{
+	OBJECT  obj;
+	OBJREC  *objp;
+
+	if (o == NULL) {		/* command */
+		readobj(mod);
+		return;
+	}
+	if ((obj = newobject()) == OVOID)
+		error(SYSTEM, "out of object space");
+	objp = objptr(obj);
+	objp->omod = getmodifier(bscname, mod);
+	objp->otype = o->otype;
+	objp->oname = savqstr(o->oname);
+	if (o->otype == MOD_ALIAS) {
+		if (o->oargs.nsargs != 1) {
+			sprintf(errmsg, "(%s): bad alias", bscname);
+			objerror(objp, USER, errmsg);
+		}
+		setalias(bscname, objp, o->oargs.sarg[0]);
+		freefargs(&o->oargs);
+	} else
+		objp->oargs = o->oargs;
+	endobject(bscname, obj);
+}
+
+
 void
 getobject(				/* read the next object */
 	char  *name,
 	FILE  *fp
 )
 {
-#define	OALIAS	-2
 	OBJECT  obj;
 	char  sbuf[MAXSTR];
 	int  rval;
@@ -90,19 +314,7 @@ getobject(				/* read the next object */
 					/* get modifier */
 	strcpy(sbuf, "EOF");
 	fgetword(sbuf, MAXSTR, fp);
-	if (strchr(sbuf, '\t')) {
-		sprintf(errmsg, "(%s): illegal tab in modifier \"%s\"",
-					name, sbuf);
-		error(USER, errmsg);
-	}
-	if (!strcmp(sbuf, VOIDID))
-		objp->omod = OVOID;
-	else if (!strcmp(sbuf, ALIASMOD))
-		objp->omod = OALIAS;
-	else if ((objp->omod = modifier(sbuf)) == OVOID) {
-		sprintf(errmsg, "(%s): undefined modifier \"%s\"", name, sbuf);
-		error(USER, errmsg);
-	}
+	objp->omod = getmodifier(name, sbuf);
 					/* get type */
 	strcpy(sbuf, "EOF");
 	fgetword(sbuf, MAXSTR, fp);
@@ -121,24 +333,9 @@ getobject(				/* read the next object */
 	objp->oname = savqstr(sbuf);
 					/* get arguments */
 	if (objp->otype == MOD_ALIAS) {
-		OBJECT  alias;
 		strcpy(sbuf, "EOF");
 		fgetword(sbuf, MAXSTR, fp);
-		if ((alias = modifier(sbuf)) == OVOID) {
-			sprintf(errmsg, "(%s): bad reference \"%s\"",
-					name, sbuf);
-			objerror(objp, USER, errmsg);
-		}
-		if (objp->omod == OALIAS || 
-				objp->omod == objptr(alias)->omod) {
-			objp->omod = alias;
-		} else {
-			objp->oargs.sarg = (char **)malloc(sizeof(char *));
-			if (objp->oargs.sarg == NULL)
-				error(SYSTEM, "out of memory in getobject");
-			objp->oargs.nsargs = 1;
-			objp->oargs.sarg[0] = savestr(sbuf);
-		}
+		setalias(name, objp, sbuf);
 	} else if ((rval = readfargs(&objp->oargs, fp)) == 0) {
 		sprintf(errmsg, "(%s): bad arguments", name);
 		objerror(objp, USER, errmsg);
@@ -146,16 +343,7 @@ getobject(				/* read the next object */
 		sprintf(errmsg, "(%s): error reading scene", name);
 		error(SYSTEM, errmsg);
 	}
-	if (objp->omod == OALIAS) {
-		sprintf(errmsg, "(%s): inappropriate use of '%s' modifier",
-				name, ALIASMOD);
-		objerror(objp, USER, errmsg);
-	}
-					/* initialize */
-	objp->os = NULL;
-
-	insertobject(obj);		/* add to global structure */
-#undef OALIAS
+	endobject(name, obj);
 }
 
 
@@ -127,6 +127,7 @@ extern int	isint(char *s);
 extern int	isintd(char *s, char *ds);
 extern int	isflt(char *s);
 extern int	isfltd(char *s, char *ds);
+extern int	fltcvt(char *s, double *vp);
 					/* defined in lamp.c */
 extern float *	matchlamp(char *s);
 extern int	loadlamps(char *file);
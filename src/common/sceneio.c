@@ -4,7 +4,7 @@ static const char RCSid[] = "$Id: sceneio.c,v 2.5 2011/09/22 02:15:56 greg Exp $
 /*
  *  Portable, binary Radiance i/o routines.
  *
- *  Called from octree and mesh i/o routines.
+ *  Called from octree and mesh i/o routines, and for binary scene files.
  */
 
 #include "copyright.h"
@@ -12,6 +12,7 @@ static const char RCSid[] = "$Id: sceneio.c,v 2.5 2011/09/22 02:15:56 greg Exp $
 #include "octree.h"
 #include "object.h"
 #include "otypes.h"
+#include "lookup.h"
 
 static OBJECT  object0;			/* zeroeth object */
 static short  otypmap[NUMOTYPE+32];	/* object type map */
@@ -157,3 +158,234 @@ writescene(				/* write binary scene description */
 	if (ferror(fp))
 		error(SYSTEM, "write error in writescene");
 }
+
+
+/*
+ *  A binary scene file holds the same information as a text scene.
+ *  Following the header and magic number is the object type list,
+ *  then one record per object or command.  Modifiers are given by
+ *  name, in a table that grows as new names are used, so they are
+ *  resolved when the scene is loaded just as for text.  Real arguments
+ *  are written as doubles, so they load back exactly as from text.
+ */
+
+#define	BSC_END		-1		/* record type for end of scene */
+#define	BSC_CMD		-2		/* record type for command */
+
+static LUTAB  bsmods = LU_SINIT(free,NULL);	/* modifier names written */
+static int  nbsmods = 0;			/* # modifier names written */
+
+
+void
+beginbscene(			/* start binary scene after header */
+	FILE	*fp
+)
+{
+	int	i;
+
+	lu_done(&bsmods);
+	nbsmods = 0;
+	putint((long)BSCMAGIC, 2, fp);
+					/* write out type list */
+	for (i = 0; i < NUMOTYPE; i++)
+		putstr(ofun[i].funame, fp);
+	putstr("", fp);
+}
+
+
+void
+putbscene(			/* write object with modifier, or command */
+	char	*mod,
+	OBJREC	*o,
+	FILE	*fp
+)
+{
+	LUENT	*ent;
+	double	d;
+	int	i;
+
+	if (o == NULL) {		/* command line */
+		putint((long)BSC_CMD, 1, fp);
+		putstr(mod, fp);
+		return;
+	}
+	putint((long)o->otype, 1, fp);
+	if ((ent = lu_find(&bsmods, mod)) == NULL)
+		goto memerr;
+	if (ent->key == NULL) {		/* new modifier name */
+		if ((ent->key = (char *)malloc(strlen(mod)+1)) == NULL)
+			goto memerr;
+		strcpy(ent->key, mod);
+		ent->data = (char *)(size_t)++nbsmods;
+		putint((long)nbsmods-1, 4, fp);
+		putstr(mod, fp);
+	} else
+		putint((long)(size_t)ent->data-1, 4, fp);
+	putstr(o->oname, fp);
+	putint((long)o->oargs.nsargs, 2, fp);
+	for (i = 0; i < o->oargs.nsargs; i++)
+		putstr(o->oargs.sarg[i], fp);
+#ifdef  IARGS
+	putint((long)o->oargs.niargs, 2, fp);
+	for (i = 0; i < o->oargs.niargs; i++)
+		putint((long)o->oargs.iarg[i], 4, fp);
+#endif
+	putint((long)o->oargs.nfargs, 2, fp);
+	for (i = 0; i < o->oargs.nfargs; i++) {
+		d = o->oargs.farg[i];
+		putbinary(&d, sizeof(double), 1, fp);
+	}
+	return;
+memerr:
+	error(SYSTEM, "out of memory in putbscene");
+}
+
+
+void
+endbscene(			/* finish binary scene */
+	FILE	*fp
+)
+{
+	putint((long)BSC_END, 1, fp);
+	lu_done(&bsmods);
+	nbsmods = 0;
+	if (ferror(fp))
+		error(SYSTEM, "write error in endbscene");
+}
+
+
+static int
+bschead(			/* check binary scene header line */
+	char	*s,
+	void	*p
+)
+{
+	char	fmt[MAXFMTLEN];
+	int	bigend;
+
+	if (formatval(fmt, s))
+		((int *)p)[0] = strcmp(fmt, SCENEFMT) ? -1 : 1;
+	else if ((bigend = isbigendian(s)) >= 0)
+		((int *)p)[1] = bigend;
+	return(0);
+}
+
+
+int
+readbscene(			/* read binary scene after initial "#?" */
+	char	*name,
+	FILE	*fp,
+	bsc_cbfunc	*f
+)
+{
+	char	sbuf[MAXSTR], nbuf[MAXSTR];
+	short	tmap[NUMOTYPE+32];
+	int	hinfo[2];
+	char	**mods = NULL;
+	int	nmods = 0;
+	int	ntypes, i, m;
+	OBJREC	o;
+
+	if (fgets(sbuf, sizeof(sbuf), fp) == NULL ||
+			strncmp(sbuf, "RADIANCE", 8))
+		return(0);		/* just a comment */
+	hinfo[0] = 0; hinfo[1] = -1;
+	if (getheader(fp, bschead, hinfo) < 0 || hinfo[0] <= 0) {
+		sprintf(errmsg, "(%s): not a binary scene file", name);
+		error(USER, errmsg);
+	}
+	if (getint(2, fp) != BSCMAGIC) {
+		sprintf(errmsg, "(%s): incompatible binary scene format", name);
+		error(USER, errmsg);
+	}
+					/* read type map */
+	for (ntypes = 0; getstr(sbuf, fp) != NULL && sbuf[0]; ntypes++) {
+		if (ntypes >= NUMOTYPE+32)
+			goto fmterr;
+		if ((tmap[ntypes] = otype(sbuf)) < 0) {
+			sprintf(errmsg, "(%s): unknown object type \"%s\"",
+					name, sbuf);
+			error(WARNING, errmsg);
+		}
+	}
+	o.omod = OVOID;
+	o.os = NULL;
+					/* read records */
+	while ((i = getint(1, fp)) != BSC_END) {
+		if (i == BSC_CMD) {
+			if (getstr(sbuf, fp) == NULL)
+				break;
+			(*f)(sbuf, NULL);
+			continue;
+		}
+		if (i < 0 || i >= ntypes)
+			goto fmterr;
+		if ((o.otype = tmap[i]) < 0) {
+			sprintf(errmsg, "(%s): reference to unknown type", name);
+			error(USER, errmsg);
+		}
+		if ((m = getint(4, fp)) == nmods) {
+			if (!(nmods & 0xff)) {
+				mods = (char **)realloc((void *)mods,
+						(nmods+0x100)*sizeof(char *));
+				if (mods == NULL)
+					goto memerr;
+			}
+			mods[nmods++] = savestr(getstr(sbuf, fp));
+		} else if (m < 0 || m > nmods)
+			goto fmterr;
+		o.oname = getstr(nbuf, fp);
+		if ((o.oargs.nsargs = getint(2, fp)) > 0) {
+			o.oargs.sarg = (char **)malloc
+					(o.oargs.nsargs*sizeof(char *));
+			if (o.oargs.sarg == NULL)
+				goto memerr;
+			for (i = 0; i < o.oargs.nsargs; i++)
+				o.oargs.sarg[i] = savestr(getstr(sbuf, fp));
+		} else
+			o.oargs.sarg = NULL;
+#ifdef	IARGS
+		if ((o.oargs.niargs = getint(2, fp)) > 0) {
+			o.oargs.iarg = (long *)malloc
+					(o.oargs.niargs*sizeof(long));
+			if (o.oargs.iarg == NULL)
+				goto memerr;
+			for (i = 0; i < o.oargs.niargs; i++)
+				o.oargs.iarg[i] = getint(4, fp);
+		} else
+			o.oargs.iarg = NULL;
+#endif
+		if ((o.oargs.nfargs = getint(2, fp)) > 0) {
+			o.oargs.farg = (RREAL *)malloc
+					(o.oargs.nfargs*sizeof(double));
+			if (o.oargs.farg == NULL)
+				goto memerr;
+			getbinary(o.oargs.farg, sizeof(double),
+					o.oargs.nfargs, fp);
+			if (hinfo[1] >= 0 && hinfo[1] != nativebigendian())
+				swap64((char *)o.oargs.farg, o.oargs.nfargs);
+			if (sizeof(RREAL) != sizeof(double))
+				for (i = 0; i < o.oargs.nfargs; i++)
+					o.oargs.farg[i] = ((double *)o.oargs.farg)[i];
+		} else
+			o.oargs.farg = NULL;
+		if (feof(fp))
+			break;
+		(*f)(mods[m], &o);	/* callee takes arguments */
+	}
+	if (feof(fp)) {
+		sprintf(errmsg, "(%s): unexpected EOF in binary scene", name);
+		error(USER, errmsg);
+	}
+	for (i = 0; i < nmods; i++)
+		freestr(mods[i]);
+	if (mods != NULL)
+		free((void *)mods);
+	return(1);
+fmterr:
+	sprintf(errmsg, "(%s): bad binary scene format", name);
+	error(USER, errmsg);
+memerr:
+	error(SYSTEM, "out of memory in readbscene");
+	return(0); /* pro forma return */
+}
@@ -34,6 +34,8 @@ extern "C" {
 
 #define HISTEP		16		/* steps in BRTSCALE for each bin */
 
+#define TM_MAPCHUNK	512		/* pixels per tmMapPixels() batch */
+
 #define MINBRT		(-16*TM_BRTSCALE)	/* minimum usable brightness */
 #define MINLUM		(1.125352e-7)		/* tmLuminance(MINBRT) */
 
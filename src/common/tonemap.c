@@ -261,8 +261,11 @@ int	len
 	static uby8	gamtab[1024];
 	static double	curgam = .0;
 	COLOR	cmon;
+	COLORMAT	cmat;
+	float	clf[3], sf;
 	float	lum, slum, d;
-	int	i;
+	int	needmat, mesopic, bw;
+	int	i, j;
 
 	if (tms == NULL)
 		returnErr(TM_E_TMINVAL);
@@ -275,13 +278,26 @@ int	len
 		for (i = 1024; i--; )
 			gamtab[i] = (int)(256.*pow((i+.5)/1024., 1./curgam));
 	}
+	/*
+	 * Copy loop invariants to locals, since stores through cs
+	 * may alias *tms and would otherwise force reloads per pixel.
+	 */
+	needmat = tmNeedMatrix(tms);
+	mesopic = tms->flags & TM_F_MESOPIC;
+	bw = tms->flags & TM_F_BW;
+	sf = tms->inpsf;
+	for (i = 0; i < 3; i++) {
+		clf[i] = tms->clf[i];
+		for (j = 0; j < 3; j++)
+			cmat[i][j] = tms->cmat[i][j];
+	}
 	for (i = len; i--; ) {
-		if (tmNeedMatrix(tms)) {		/* get monitor RGB */
-			colortrans(cmon, tms->cmat, scan[i]);
+		if (needmat) {				/* get monitor RGB */
+			colortrans(cmon, cmat, scan[i]);
 		} else {
-			cmon[RED] = tms->inpsf*scan[i][RED];
-			cmon[GRN] = tms->inpsf*scan[i][GRN];
-			cmon[BLU] = tms->inpsf*scan[i][BLU];
+			cmon[RED] = sf*scan[i][RED];
+			cmon[GRN] = sf*scan[i][GRN];
+			cmon[BLU] = sf*scan[i][BLU];
 		}
 #ifdef isfinite
 		if (!isfinite(cmon[RED]) || cmon[RED] < .0f) cmon[RED] = .0f;
@@ -293,9 +309,9 @@ int	len
 		if (cmon[BLU] < .0f) cmon[BLU] = .0f;
 #endif
 							/* world luminance */
-		lum =	tms->clf[RED]*cmon[RED] +
-			tms->clf[GRN]*cmon[GRN] +
-			tms->clf[BLU]*cmon[BLU] ;
+		lum =	clf[RED]*cmon[RED] +
+			clf[GRN]*cmon[GRN] +
+			clf[BLU]*cmon[BLU] ;
 		if (lum <= TM_NOLUM) {			/* convert brightness */
 			lum = cmon[RED] = cmon[GRN] = cmon[BLU] = TM_NOLUM;
 			ls[i] = TM_NOBRT;
@@ -303,13 +319,13 @@ int	len
 			ls[i] = tmCvLumLUfp(&lum);
 		if (cs == TM_NOCHROM)			/* no color? */
 			continue;
-		if (tms->flags & TM_F_MESOPIC && lum < LMESUPPER) {
+		if (mesopic && lum < LMESUPPER) {
 			slum = scotlum(cmon);		/* mesopic adj. */
 			if (lum < LMESLOWER) {
 				cmon[RED] = cmon[GRN] = cmon[BLU] = slum;
 			} else {
 				d = (lum - LMESLOWER)/(LMESUPPER - LMESLOWER);
-				if (tms->flags & TM_F_BW)
+				if (bw)
 					cmon[RED] = cmon[GRN] =
 							cmon[BLU] = d*lum;
 				else
@@ -319,14 +335,14 @@ int	len
 				cmon[GRN] += d;
 				cmon[BLU] += d;
 			}
-		} else if (tms->flags & TM_F_BW) {
+		} else if (bw) {
 			cmon[RED] = cmon[GRN] = cmon[BLU] = lum;
 		}
-		d = tms->clf[RED]*cmon[RED]/lum;
+		d = clf[RED]*cmon[RED]/lum;
 		cs[3*i  ] = d>=.999f ? 255 : gamtab[(int)(1024.f*d)];
-		d = tms->clf[GRN]*cmon[GRN]/lum;
+		d = clf[GRN]*cmon[GRN]/lum;
 		cs[3*i+1] = d>=.999f ? 255 : gamtab[(int)(1024.f*d)];
-		d = tms->clf[BLU]*cmon[BLU]/lum;
+		d = clf[BLU]*cmon[BLU]/lum;
 		cs[3*i+2] = d>=.999f ? 255 : gamtab[(int)(1024.f*d)];
 	}
 	returnOK;
@@ -343,6 +359,8 @@ int	wt
 {
 	static const char funcName[] = "tmAddHisto";
 	int	oldorig=0, oldlen, horig, hlen;
+	int	*hist;
+	int	bmin, bmax;
 	int	i, j;
 
 	if (tms == NULL)
@@ -363,16 +381,18 @@ int	wt
 		oldorig = HISTI(tms->hbrmin);
 		oldlen = HISTI(tms->hbrmax) + 1 - oldorig;
 	}
+	bmin = tms->hbrmin; bmax = tms->hbrmax;
 	for (i = len; i--; ) {
 		if ((j = ls[i]) < MINBRT)
 			continue;
-		if (j < tms->hbrmin)
-			tms->hbrmin = j;
-		else if (j > tms->hbrmax)
-			tms->hbrmax = j;
+		if (j < bmin)
+			bmin = j;
+		else if (j > bmax)
+			bmax = j;
 	}
-	horig = HISTI(tms->hbrmin);
-	hlen = HISTI(tms->hbrmax) + 1 - horig;
+	tms->hbrmin = bmin; tms->hbrmax = bmax;
+	horig = HISTI(bmin);
+	hlen = HISTI(bmax) + 1 - horig;
 	if (hlen > oldlen) {			/* (re)allocate histogram */
 		int	*newhist = (int *)calloc(hlen, sizeof(int));
 		if (newhist == NULL)
@@ -386,9 +406,10 @@ int	wt
 	}
 	if (wt == 0)
 		returnOK;
+	hist = tms->histo;
 	for (i = len; i--; )			/* add in new counts */
 		if (ls[i] >= MINBRT)
-			tms->histo[ HISTI(ls[i]) - horig ] += wt;
+			hist[ HISTI(ls[i]) - horig ] += wt;
 	returnOK;
 }
 
@@ -562,30 +583,50 @@ int	len
 )
 {
 	static const char funcName[] = "tmMapPixels";
+	int32	lbuf[TM_MAPCHUNK];
+	double	rdiv[3];
+	unsigned short	*lumap;
+	int	bmin, bmax;
 	int32	li, pv;
+	int	n, i;
 
 	if (tms == NULL || tms->lumap == NULL)
 		returnErr(TM_E_TMINVAL);
 	if ((ps == NULL) | (ls == NULL) | (len < 0))
 		returnErr(TM_E_ILLEGAL);
-	while (len--) {
-		if ((li = *ls++) < tms->mbrmin) {
-			li = 0;
-		} else {
-			if (li > tms->mbrmax)
-				li = tms->mbrmax;
-			li = tms->lumap[li - tms->mbrmin];
+	lumap = tms->lumap;
+	bmin = tms->mbrmin; bmax = tms->mbrmax;
+	/*
+	 * Integer division by cdiv is replaced by multiplication with
+	 * a slightly enlarged reciprocal, which gives the same quotient
+	 * for products below 2^24 and divisors up to 256.
+	 */
+	for (i = 3; i--; )
+		rdiv[i] = (1. + 1./(1L<<36)) / tms->cdiv[i];
+	while (len > 0) {			/* map a batch at a time */
+		n = len < TM_MAPCHUNK ? len : TM_MAPCHUNK;
+		for (i = 0; i < n; i++) {	/* luminance lookups */
+			li = ls[i];
+			li = li > bmax ? bmax : li;
+			lbuf[i] = li < bmin ? 0 : lumap[li - bmin];
 		}
-		if (cs == TM_NOCHROM)
-			*ps++ = li>255 ? 255 : li;
-		else {
-			pv = *cs++ * li / tms->cdiv[RED];
-			*ps++ = pv>255 ? 255 : pv;
-			pv = *cs++ * li / tms->cdiv[GRN];
-			*ps++ = pv>255 ? 255 : pv;
-			pv = *cs++ * li / tms->cdiv[BLU];
-			*ps++ = pv>255 ? 255 : pv;
+		if (cs == TM_NOCHROM) {
+			for (i = 0; i < n; i++)
+				ps[i] = lbuf[i]>255 ? 255 : lbuf[i];
+			ps += n;
+		} else {
+			for (i = 0; i < n; i++) {
+				pv = (int32)(cs[0]*lbuf[i] * rdiv[RED]);
+				ps[0] = pv>255 ? 255 : pv;
+				pv = (int32)(cs[1]*lbuf[i] * rdiv[GRN]);
+				ps[1] = pv>255 ? 255 : pv;
+				pv = (int32)(cs[2]*lbuf[i] * rdiv[BLU]);
+				ps[2] = pv>255 ? 255 : pv;
+				cs += 3; ps += 3;
+			}
 		}
+		ls += n;
+		len -= n;
 	}
 	returnOK;
 }
@@ -10,6 +10,7 @@ static const char RCSid[] = "$Id: words.c,v 2.12 2019/12/28 18:05:14 greg Exp $"
 #include "copyright.h"
 
 #include  <ctype.h>
+#include  <stdlib.h>
 
 #include  "rtio.h"
 
@@ -158,6 +159,62 @@ isfltd(char *s, char *ds)	/* check integer format with delimiter set */
 }
 
 
+int
+fltcvt(char *s, double *vp)	/* check float format and convert */
+{
+	static const double  p10[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+			1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+			1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	unsigned long long  m = 0;
+	int  nd = 0, ndig = 0, ex = 0, e = 0;
+	int  neg = 0, eneg = 0;
+	char  *cp = s;
+					/* Clinger's fast path: an exact */
+	while (isspace(*cp))		/* mantissa and power of ten give */
+		cp++;			/* the same rounding as atof() */
+	if ((*cp == '-') | (*cp == '+'))
+		neg = (*cp++ == '-');
+	for ( ; isdigit(*cp); cp++, nd++)
+		if (((m > 0) | (*cp != '0')) && ++ndig <= 19)
+			m = m*10 + (*cp - '0');
+		else if (m > 0)
+			ex++;
+	if (*cp == '.') {
+		for (cp++; isdigit(*cp); cp++, nd++)
+			if (((m > 0) | (*cp != '0')) && ++ndig <= 19) {
+				m = m*10 + (*cp - '0');
+				ex--;
+			} else if (m == 0)
+				ex--;
+	}
+	if (!nd)
+		return(0);
+	if ((*cp == 'e') | (*cp == 'E')) {
+		cp++;
+		if ((*cp == '-') | (*cp == '+'))
+			eneg = (*cp++ == '-');
+		if (!isdigit(*cp))
+			return(0);
+		while (isdigit(*cp)) {
+			if (e < 10000)
+				e = e*10 + (*cp - '0');
+			cp++;
+		}
+	}
+	if (*cp)
+		return(0);
+	ex += eneg ? -e : e;
+	if ((ndig > 19) | (m > 1ULL<<53) | (ex < -22) | (ex > 22)) {
+		*vp = atof(s);		/* not exact, take slow road */
+		return(1);
+	}
+	*vp = ex < 0 ? (double)m / p10[-ex] : (double)m * p10[ex];
+	if (neg)
+		*vp = -*vp;
+	return(1);
+}
+
+
 int
 isname(char *s)			/* check for legal identifier name */
 {
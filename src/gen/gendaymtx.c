@@ -271,15 +271,18 @@ int		nskypatch;		/* number of Reinhart patches */
 float		*rh_palt;		/* sky patch altitudes (radians) */
 float		*rh_pazi;		/* sky patch azimuths (radians) */
 float		*rh_dom;		/* sky patch solid angle (sr) */
+FVECT		*rh_pvec;		/* sky patch direction vectors */
+double		*rh_czen;		/* cosine of patch zenith angle */
+double		*rh_szen;		/* sine of patch zenith angle */
 
 #define		vector(v,alt,azi)	(	(v)[1] = tcos(alt), \
 						(v)[0] = (v)[1]*tsin(azi), \
 						(v)[1] *= tcos(azi), \
 						(v)[2] = tsin(alt) )
 
-#define		rh_vector(v,i)		vector(v,rh_palt[i],rh_pazi[i])
+#define		rh_vector(v,i)		VCOPY(v,rh_pvec[i])
 
-#define		rh_cos(i)		tsin(rh_palt[i])
+#define		rh_cos(i)		rh_pvec[i][2]
 
 extern int	rh_init(void);
 extern float *	resize_dmatrix(float *mtx_data, int nsteps, int npatch);
@@ -321,6 +324,7 @@ main(int argc, char *argv[])
 	double	hr;			/* hour (local standard time) */
 	double	dir, dif;		/* direct and diffuse values */
 	int	mtx_offset;
+	double	*rowbuf = NULL;		/* binary output row */
 	int	i, j;
 
 	progname = argv[0];
@@ -569,6 +573,11 @@ main(int argc, char *argv[])
 			fputendian(stdout);
 		fputformat((char *)getfmtname(outfmt), stdout);
 		putchar('\n');
+	}
+	if (((outfmt == 'f') | (outfmt == 'd')) &&
+			(rowbuf = (double *)malloc(sizeof(double)*3*nstored)) == NULL) {
+		fprintf(stderr, "%s: out of memory for output row\n", progname);
+		exit(1);
 	}
 					/* patches are rows (outer sort) */
 	for (i = 0; i < nskypatch; i++) {
@@ -584,22 +593,22 @@ main(int argc, char *argv[])
 			if (nstored > 1)
 				fputc('\n', stdout);
 			break;
-		case 'f':
+		case 'f':			/* gather row, then write */
 			for (j = 0; j < nstored; j++) {
-				putbinary(mtx_data+mtx_offset, sizeof(float), 3,
-						stdout);
+				memcpy((float *)rowbuf+3*j, mtx_data+mtx_offset,
+						sizeof(float)*3);
 				mtx_offset += 3*nskypatch;
 			}
+			putbinary(rowbuf, sizeof(float), 3*nstored, stdout);
 			break;
 		case 'd':
 			for (j = 0; j < nstored; j++) {
-				double	ment[3];
-				ment[0] = mtx_data[mtx_offset];
-				ment[1] = mtx_data[mtx_offset+1];
-				ment[2] = mtx_data[mtx_offset+2];
-				putbinary(ment, sizeof(double), 3, stdout);
+				rowbuf[3*j] = mtx_data[mtx_offset];
+				rowbuf[3*j+1] = mtx_data[mtx_offset+1];
+				rowbuf[3*j+2] = mtx_data[mtx_offset+2];
 				mtx_offset += 3*nskypatch;
 			}
+			putbinary(rowbuf, sizeof(double), 3*nstored, stdout);
 			break;
 		}
 		if (ferror(stdout))
@@ -813,7 +822,11 @@ rh_init(void)
 	rh_palt = (float *)malloc(sizeof(float)*nskypatch);
 	rh_pazi = (float *)malloc(sizeof(float)*nskypatch);
 	rh_dom = (float *)malloc(sizeof(float)*nskypatch);
-	if ((rh_palt == NULL) | (rh_pazi == NULL) | (rh_dom == NULL)) {
+	rh_pvec = (FVECT *)malloc(sizeof(FVECT)*nskypatch);
+	rh_czen = (double *)malloc(sizeof(double)*nskypatch);
+	rh_szen = (double *)malloc(sizeof(double)*nskypatch);
+	if ((rh_palt == NULL) | (rh_pazi == NULL) | (rh_dom == NULL) |
+			(rh_pvec == NULL) | (rh_czen == NULL) | (rh_szen == NULL)) {
 		fprintf(stderr, "%s: out of memory in rh_init()\n", progname);
 		exit(1);
 	}
@@ -835,6 +848,12 @@ rh_init(void)
 			rh_dom[p++] = dom;
 		}
 	}
+	for (p = 0; p < nskypatch; p++) {
+					/* per-patch terms for each time step */
+		vector(rh_pvec[p], rh_palt[p], rh_pazi[p]);
+		rh_czen[p] = cos(PI * 0.5 - rh_palt[p]);
+		rh_szen[p] = sin(PI * 0.5 - rh_palt[p]);
+	}
 	return nskypatch;
 #undef NROW
 }
@@ -1174,27 +1193,32 @@ double CalcAirMass()
 /*       for the Validation of Illuminance Prediction Techniques," */
 /*       Lighting Research & Technology 33(2):117-136.) */
 
+/* NOTE: Patch zenith angle terms come from rh_init(), and sun terms */
+/*       are computed once per time step, so only the Perez model */
+/*       itself is evaluated in the patch loop (Eqn. 1 inlined). */
+
 void CalcSkyPatchLumin( float *parr )
 {
+	const double csz = cos(sun_zenith);	/* Sun zenith cosine */
+	const double ssz = sin(sun_zenith);	/* Sun zenith sine */
 	int i;
 	double aas;				/* Sun-sky point azimuthal angle */
 	double sspa;			/* Sun-sky point angle */
-	double zsa;				/* Zenithal sun angle */
+	double cg;				/* Its cosine */
 
 	for (i = 1; i < nskypatch; i++)
 	{
 		/* Calculate sun-sky point azimuthal angle */
 		aas = fabs(rh_pazi[i] - azimuth);
 
-		/* Calculate zenithal sun angle */
-		zsa = PI * 0.5 - rh_palt[i];
-
 		/* Calculate sun-sky point angle (Equation 8-20) */
-		sspa = acos(cos(sun_zenith) * cos(zsa) + sin(sun_zenith) *
-				sin(zsa) * cos(aas));
+		sspa = acos(csz * rh_czen[i] + ssz * rh_szen[i] * cos(aas));
 
 		/* Calculate patch luminance */
-		parr[3*i] = CalcRelLuminance(sspa, zsa);
+		cg = cos(sspa);
+		parr[3*i] = (1.0 + perez_param[0] * exp(perez_param[1] /
+				rh_czen[i])) * (1.0 + perez_param[2] *
+				exp(perez_param[3] * sspa) + perez_param[4] * cg * cg);
 		if (parr[3*i] < 0) parr[3*i] = 0;
 		parr[3*i+2] = parr[3*i+1] = parr[3*i];
 	}
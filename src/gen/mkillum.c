@@ -122,6 +122,7 @@ main(		/* compute illum distributions using rtrace */
 		}
 	} else
 		filter(stdin, "standard input");
+	rayclean();			/* write out what's left */
 	quit(0);
 	return 0; /* pro forma return */
 }
@@ -228,9 +229,10 @@ xoptions(			/* process options in string s */
 	char	*cp;
 
 	if (strncmp(s, "#@mkillum", 9) || !isspace(s[9])) {
-		fputs(s, stdout);		/* not for us */
+		outtext(s);			/* not for us */
 		return;
 	}
+	rayclean();			/* finish objects before options */
 	cp = s+10;
 	while (*cp) {
 		switch (*cp) {
@@ -437,12 +439,14 @@ xobject(				/* translate an object from fp */
 		goto readerr;
 					/* is it an alias? */
 	if (!strcmp(str, ALIASKEY)) {
+		char  alias[3*MAXSTR+16];
 		if (fgetword(str, MAXSTR, fp) == NULL)
 			goto readerr;
-		printf("\n%s %s %s", thisillum.altmat, ALIASKEY, str);
+		sprintf(alias, "\n%s %s %s", thisillum.altmat, ALIASKEY, str);
 		if (fgetword(str, MAXSTR, fp) == NULL)
 			goto readerr;
-		printf("\t%s\n", str);
+		sprintf(alias+strlen(alias), "\t%s\n", str);
+		outtext(alias);
 		return;
 	}
 	thisobj.omod = OVOID;		/* unused field */
@@ -491,7 +495,7 @@ xobject(				/* translate an object from fp */
 			break;
 		}
 	else
-		printobj(thisillum.altmat, &thisobj);
+		endsurf(&thisobj, &thisillum, SO_PRINT, 0, 0, NULL, NULL, NULL);
 						/* free arguments */
 	freefargs(&thisobj.oargs);
 	return;
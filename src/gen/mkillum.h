@@ -17,6 +17,10 @@ extern "C" {
 #define  IL_COLDST	0x2		/* use color distribution */
 #define  IL_COLAVG	0x4		/* use average color */
 #define  IL_DATCLB	0x8		/* OK to clobber data file */
+				/* surface output kinds */
+#define  SO_PRINT	0		/* print object as given */
+#define  SO_FLAT	1		/* hemispherical distribution */
+#define  SO_ROUND	2		/* spherical distribution */
 
 struct illum_args {
 	int	flags;			/* flags from list above */
@@ -37,7 +41,10 @@ extern void flatout(struct illum_args *il, COLORV *da, int n, int m,
 extern void illumout(struct illum_args *il, OBJREC *ob);
 extern void roundout(struct illum_args *il, COLORV *da, int n, int m);
 
-extern void newdist(int siz);
+extern void newsurf(int siz);
+extern void endsurf(OBJREC *ob, struct illum_args *il, int kind,
+	int nalt, int nazi, FVECT u, FVECT v, FVECT w);
+extern void outtext(char *s);
 extern int process_ray(RAY *r, int rv);
 extern void raysamp(int ndx, FVECT org, FVECT dir);
 extern void rayclean(void);
@@ -50,9 +57,6 @@ extern int my_face(OBJREC *, struct illum_args *, char *);
 extern int my_sphere(OBJREC *, struct illum_args *, char *);
 extern int my_ring(OBJREC *, struct illum_args *, char *);
 
-extern COLORV *	distarr;		/* distribution array */
-extern int	distsiz;
-
 extern char	*progname;
 
 #ifdef __cplusplus
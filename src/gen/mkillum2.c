@@ -17,31 +17,189 @@ static const char	RCSid[] = "$Id: mkillum2.c,v 2.42 2016/09/16 15:08:38 greg Exp
 #define R_EPS		0.005		/* relative epsilon for ray origin */
 #endif
 
-COLORV *	distarr = NULL;		/* distribution array */
-int		distsiz = 0;
+/*
+ * Surfaces are not finished one at a time.  Each one gets its own
+ * distribution and waits in a queue until all of its rays are back,
+ * while rays for the surfaces after it keep the rendering processes
+ * busy.  Output is written from the head of the queue, in input order.
+ */
+
+#ifndef MAXPEND
+#define MAXPEND		512		/* most objects waiting for output */
+#endif
+
+#define SO_TEXT		3		/* output kind for text */
+
+typedef struct ilsurf {
+	int	kind;			/* output kind, or -1 if sampling */
+	OBJREC	obj;			/* object, owning its arguments */
+	char	oname[MAXSTR];		/* object name */
+	char	*text;			/* text to copy for SO_TEXT */
+	struct illum_args  il;		/* options for this object */
+	struct illum_args  *ilorig;	/* where file numbering continues */
+	COLORV	*dist;			/* distribution array */
+	int	n, nalt, nazi;		/* distribution size and dimensions */
+	FVECT	u, v, w;		/* axes for hemispherical output */
+	RNUMBER	base;			/* number of first ray */
+	long	nleft;			/* rays still out */
+	struct ilsurf	*next;		/* next in queue */
+} ILSURF;
+
+static ILSURF	*sqhead = NULL;		/* output queue */
+static ILSURF	*sqtail = NULL;
+static int	sqlen = 0;		/* # objects in queue */
+static ILSURF	*cursurf = NULL;	/* surface being sampled */
+static RNUMBER	nextbase = 0;		/* ray number for next surface */
+
+
+static ILSURF *
+addsurf(			/* add new object to output queue */
+	int siz
+)
+{
+	ILSURF	*sp = (ILSURF *)calloc(1, sizeof(ILSURF));
+
+	if (sp == NULL)
+		goto memerr;
+	if ((sp->n = siz) > 0) {
+		sp->dist = (COLORV *)calloc(siz, sizeof(COLOR));
+		if (sp->dist == NULL)
+			goto memerr;
+	}
+	sp->kind = -1;
+	sp->base = nextbase;
+	nextbase += siz;
+	if (sqtail == NULL)
+		sqhead = sp;
+	else
+		sqtail->next = sp;
+	sqtail = sp;
+	sqlen++;
+	return(sp);
+memerr:
+	error(SYSTEM, "out of memory in addsurf");
+	return(NULL);	/* pro forma return */
+}
+
+
+static void
+outsurf(			/* write out object and free it */
+	ILSURF *sp
+)
+{
+	switch (sp->kind) {
+	case SO_TEXT:
+		fputs(sp->text, stdout);
+		freestr(sp->text);
+		break;
+	case SO_PRINT:
+		printobj(sp->il.altmat, &sp->obj);
+		break;
+	case SO_FLAT:
+	case SO_ROUND:
+		sp->il.dfnum = sp->ilorig->dfnum;
+		if (!average(&sp->il, sp->dist, sp->n)) {
+			printobj(sp->il.altmat, &sp->obj);
+			break;
+		}
+		if (sp->kind == SO_FLAT) {
+			if (sp->il.sampdens > 0)
+				flatout(&sp->il, sp->dist, sp->nalt, sp->nazi,
+						sp->u, sp->v, sp->w);
+		} else if (sp->il.sampdens > 0)
+			roundout(&sp->il, sp->dist, sp->nalt, sp->nazi);
+		else
+			objerror(&sp->obj, WARNING, "diffuse distribution");
+		illumout(&sp->il, &sp->obj);
+		sp->ilorig->dfnum = sp->il.dfnum;
+		break;
+	}
+	freefargs(&sp->obj.oargs);
+	if (sp->dist != NULL)
+		free(sp->dist);
+	free(sp);
+}
+
+
+static void
+flushsurfs(void)		/* write out finished objects in order */
+{
+	ILSURF	*sp;
+
+	while ((sp = sqhead) != NULL && sp->kind >= 0 && sp->nleft <= 0) {
+		if ((sqhead = sp->next) == NULL)
+			sqtail = NULL;
+		sqlen--;
+		outsurf(sp);
+	}
+}
 
 
 void
-newdist(			/* allocate & clear distribution array */
+newsurf(			/* start sampling a new surface */
 	int siz
 )
 {
-	if (siz <= 0) {
-		if (distsiz > 0)
-			free(distarr);
-		distarr = NULL;
-		distsiz = 0;
-		return;
+	if (cursurf != NULL)
+		error(INTERNAL, "missing endsurf in newsurf");
+	cursurf = addsurf(siz);
+}
+
+
+void
+endsurf(			/* finish surface, queuing its output */
+	OBJREC *ob,
+	struct illum_args *il,
+	int kind,
+	int nalt,
+	int nazi,
+	FVECT u,
+	FVECT v,
+	FVECT w
+)
+{
+	ILSURF	*sp = cursurf;
+	RAY	myRay;
+
+	if (sp == NULL)			/* nothing sampled */
+		sp = addsurf(0);
+	cursurf = NULL;
+	sp->obj = *ob;			/* take over arguments */
+	memset(&ob->oargs, '\0', sizeof(FUNARGS));
+	strcpy(sp->oname, ob->oname);
+	sp->obj.oname = sp->oname;
+	sp->obj.os = NULL;
+	sp->il = *il;
+	sp->ilorig = il;
+	sp->nalt = nalt;
+	sp->nazi = nazi;
+	if (kind == SO_FLAT) {
+		VCOPY(sp->u, u);
+		VCOPY(sp->v, v);
+		VCOPY(sp->w, w);
 	}
-	if (distsiz < siz) {
-		if (distsiz > 0)
-			free(distarr);
-		distarr = (COLORV *)malloc(sizeof(COLOR)*siz);
-		if (distarr == NULL)
-			error(SYSTEM, "out of memory in newdist");
-		distsiz = siz;
+	sp->kind = kind;
+	flushsurfs();
+					/* limit what we hold */
+	while (sqlen > MAXPEND && process_ray(&myRay, ray_presult(&myRay, 0)))
+		;
+}
+
+
+void
+outtext(			/* queue text to copy to output */
+	char *s
+)
+{
+	ILSURF	*sp;
+
+	if (sqhead == NULL) {		/* nothing waiting */
+		fputs(s, stdout);
+		return;
 	}
-	memset(distarr, '\0', sizeof(COLOR)*siz);
+	sp = addsurf(0);
+	sp->text = savestr(s);
+	sp->kind = SO_TEXT;
 }
 
 
@@ -51,17 +209,23 @@ process_ray(			/* process a ray result or report error */
 	int rv
 )
 {
+	ILSURF	*sp;
 	COLORV	*colp;
 
 	if (rv == 0)			/* no result ready */
 		return(0);
 	if (rv < 0)
 		error(USER, "ray tracing process died");
-	if (r->rno >= distsiz)
+	for (sp = sqhead; sp != NULL; sp = sp->next)
+		if (r->rno < sp->base + sp->n)
+			break;
+	if (sp == NULL || r->rno < sp->base)
 		error(INTERNAL, "bad returned index in process_ray");
 	multcolor(r->rcol, r->rcoef);	/* in case it's a source ray */
-	colp = &distarr[r->rno * 3];
+	colp = &sp->dist[(r->rno - sp->base) * 3];
 	addcolor(colp, r->rcol);
+	if (!--sp->nleft && sp == sqhead)
+		flushsurfs();
 	return(1);
 }
 
@@ -76,13 +240,14 @@ raysamp(			/* queue a ray sample */
 	RAY	myRay;
 	int	rv;
 
-	if ((ndx < 0) | (ndx >= distsiz))
+	if (cursurf == NULL || (ndx < 0) | (ndx >= cursurf->n))
 		error(INTERNAL, "bad index in raysamp");
 	VCOPY(myRay.rorg, org);
 	VCOPY(myRay.rdir, dir);
 	myRay.rmax = .0;
 	rayorigin(&myRay, PRIMARY|SPECULAR, NULL, NULL);
-	myRay.rno = ndx;
+	myRay.rno = cursurf->base + ndx;
+	cursurf->nleft++;
 					/* queue ray, check result */
 	process_ray(&myRay, ray_pqueue(&myRay));
 }
@@ -122,7 +287,8 @@ srcsamps(			/* sample sources from this surface position */
 		if (v[2] >= -FTINY)
 			continue;		/* only sample transmission */
 		v[0] = -v[0]; v[1] = -v[1]; v[2] = -v[2];
-		sr.rno = flatindex(v, nalt, nazi);
+		sr.rno = cursurf->base + flatindex(v, nalt, nazi);
+		cursurf->nleft++;
 		d = nalt*nazi*(1./PI) * v[2];
 		d *= si.dom;			/* solid angle correction */
 		scalecolor(sr.rcoef, d);
@@ -133,12 +299,13 @@ srcsamps(			/* sample sources from this surface position */
 
 
 void
-rayclean()			/* finish all pending rays */
+rayclean()			/* finish all pending rays and output */
 {
 	RAY	myRay;
 
 	while (process_ray(&myRay, ray_presult(&myRay, 0)))
 		;
+	flushsurfs();
 }
 
 
@@ -218,7 +385,7 @@ my_default(	/* default illum action */
 	sprintf(errmsg, "(%s): cannot make illum for %s \"%s\"",
 			nm, ofun[ob->otype].funame, ob->oname);
 	error(WARNING, errmsg);
-	printobj(il->altmat, ob);
+	endsurf(ob, il, SO_PRINT, 0, 0, NULL, NULL, NULL);
 	return(1);
 }
 
@@ -258,7 +425,7 @@ my_face(		/* make an illum face */
 		nazi = PI*nalt + .5;
 	}
 	n = nazi*nalt;
-	newdist(n);
+	newsurf(n);
 				/* take first edge >= sqrt(area) */
 	for (j = fa->nv-1, i = 0; i < fa->nv; j = i++) {
 		u[0] = VERTEX(fa,i)[0] - VERTEX(fa,j)[0];
@@ -311,7 +478,6 @@ my_face(		/* make an illum face */
 		    } while (!inface(org, fa) && nallow-- > 0);
 		    if (nallow < 0) {
 			objerror(ob, WARNING, "bad aspect");
-			rayclean();
 			freeface(ob);
 			return(my_default(ob, il, nm));
 		    }
@@ -345,7 +511,6 @@ my_face(		/* make an illum face */
 		    } while (!inface(org, fa) && nallow-- > 0);
 		    if (nallow < 0) {
 			objerror(ob, WARNING, "bad aspect");
-			rayclean();
 			freeface(ob);
 			return(my_default(ob, il, nm));
 		    }
@@ -353,15 +518,8 @@ my_face(		/* make an illum face */
 		    srcsamps(il, org, epsilon, ixfm);
 		}
 	}
-				/* wait for all rays to finish */
-	rayclean();
-				/* write out the face and its distribution */
-	if (average(il, distarr, n)) {
-		if (il->sampdens > 0)
-			flatout(il, distarr, nalt, nazi, u, v, fa->norm);
-		illumout(il, ob);
-	} else
-		printobj(il->altmat, ob);
+				/* write out when rays finish */
+	endsurf(ob, il, SO_FLAT, nalt, nazi, u, v, fa->norm);
 				/* clean up */
 	freeface(ob);
 	return(0);
@@ -393,7 +551,7 @@ my_sphere(	/* make an illum sphere */
 		nazi = PI/2.*nalt + .5;
 	}
 	n = nalt*nazi;
-	newdist(n);
+	newsurf(n);
 	dim[0] = random();
 				/* sample sphere */
 	for (dim[1] = 0; dim[1] < nalt; dim[1]++)
@@ -420,18 +578,8 @@ my_sphere(	/* make an illum sphere */
 					/* send sample */
 		    raysamp(dim[1]*nazi+dim[2], org, dir);
 		}
-				/* wait for all rays to finish */
-	rayclean();
-				/* write out the sphere and its distribution */
-	if (average(il, distarr, n)) {
-		if (il->sampdens > 0)
-			roundout(il, distarr, nalt, nazi);
-		else
-			objerror(ob, WARNING, "diffuse distribution");
-		illumout(il, ob);
-	} else
-		printobj(il->altmat, ob);
-				/* clean up */
+				/* write out when rays finish */
+	endsurf(ob, il, SO_ROUND, nalt, nazi, NULL, NULL, NULL);
 	return(1);
 }
 
@@ -467,7 +615,7 @@ my_ring(		/* make an illum ring */
 	}
 	epsilon = R_EPS*CO_R1(co);
 	n = nazi*nalt;
-	newdist(n);
+	newsurf(n);
 	mkaxes(u, v, co->ad);
 	dim[0] = random();
 				/* sample disk */
@@ -523,15 +671,8 @@ my_ring(		/* make an illum ring */
 		    srcsamps(il, org, epsilon, ixfm);
 		}
 	}
-				/* wait for all rays to finish */
-	rayclean();
-				/* write out the ring and its distribution */
-	if (average(il, distarr, n)) {
-		if (il->sampdens > 0)
-			flatout(il, distarr, nalt, nazi, u, v, co->ad);
-		illumout(il, ob);
-	} else
-		printobj(il->altmat, ob);
+				/* write out when rays finish */
+	endsurf(ob, il, SO_FLAT, nalt, nazi, u, v, co->ad);
 				/* clean up */
 	freecone(ob);
 	return(1);
@@ -49,6 +49,7 @@ FILE  *mainfp = NULL;			/* main file pointer */
 static int doargf(int ac, char **av, int fi);
 static int doarray(int ac, char **av, int ai);
 static void xform(char *name, FILE *fin);
+static void badbinary(char *name, FILE *fin);
 static void xfcomm(char *fname, FILE *fin);
 static void xfobject(char *fname, FILE *fin);
 static int addxform(FILE *fin);
@@ -347,19 +348,23 @@ xform(			/* transform stream by tot.xfm */
 	FILE  *fin
 )
 {
-	int  nobjs = 0;
+	int  nobjs = 0, first;
 	int  c;
 
-	while ((c = getc(fin)) != EOF) {
+	for (first = 1; (c = getc(fin)) != EOF; first = 0) {
 		if (isspace(c))				/* blank */
 			continue;
 		if (c == '#') {				/* comment */
-			putchar(c);
-			do {
-				if ((c = getc(fin)) == EOF)
+			if ((c = getc(fin)) == '?' && first)
+				badbinary(name, fin);	/* "#?" header */
+			putchar('#');
+			while (c != '\n') {
+				if (c == EOF)
 					return;
 				putchar(c);
-			} while (c != '\n');
+				c = getc(fin);
+			}
+			putchar(c);
 		} else if (c == '!') {			/* command */
 			ungetc(c, fin);
 			xfcomm(name, fin);
@@ -376,6 +381,38 @@ xform(			/* transform stream by tot.xfm */
 }
 
 
+static int
+fmtline(			/* get format from header line */
+	char  *s,
+	void  *p
+)
+{
+	formatval((char *)p, s);
+	return(0);
+}
+
+
+void
+badbinary(			/* reject binary input after "#?" */
+	char  *name,
+	FILE  *fin
+)
+{
+	char  fmt[MAXFMTLEN];
+
+	fmt[0] = '\0';
+	getheader(fin, fmtline, fmt);
+	if (!strcmp(fmt, SCENEFMT) && getint(2, fin) == BSCMAGIC)
+		fprintf(stderr,
+	"%s: (%s): binary scene file - convert it with \"rad2bin -r\"\n",
+				progname, name);
+	else
+		fprintf(stderr, "%s: (%s): not a scene description\n",
+				progname, name);
+	exit(1);
+}
+
+
 void
 xfcomm(			/* transform a command */
 	char  *fname,
@@ -165,6 +165,7 @@ extern off_t hdfilen(int fd);
 extern off_t hdfiluse(int fd);
 extern RAYVAL * hdnewrays(HOLO *hp, int i, int nr);
 extern BEAM * hdgetbeam(HOLO *hp, int i);
+extern void hdprefetch(HDBEAMI *hb, int n);
 extern void hdloadbeams(HDBEAMI *hb, int n, void (*bf)(BEAM *bp, HDBEAMI *hb));
 extern int hdfreebeam(HOLO *hp, int i);
 extern int hdfreefrag(HOLO *hp, int i);
@@ -10,6 +10,7 @@ static const char	RCSid[] = "$Id: holofile.c,v 3.61 2018/10/05 19:19:16 greg Exp
 #include "copyright.h"
 
 #include <string.h>
+#include <fcntl.h>
 
 #include "platform.h"
 #include "rtprocess.h"
@@ -40,6 +41,10 @@ static const char	RCSid[] = "$Id: holofile.c,v 3.61 2018/10/05 19:19:16 greg Exp
 				/* minimum directory seek length */
 #define MINDIRSEL	(4*BUFSIZ/sizeof(BEAMI))
 #endif
+#ifndef PREFETCHGAP
+				/* largest gap to read through on prefetch */
+#define PREFETCHGAP	(16*BUFSIZ)
+#endif
 
 #ifndef BSD
 #ifdef write /* platform.h renames those for Windows */
@@ -509,6 +514,38 @@ hdgetbeam(	/* get beam (from file if necessary) */
 }
 
 
+void
+hdprefetch(	/* start reading beams we will want soon */
+	HDBEAMI	*hb,
+	int	n
+)
+{
+#ifdef POSIX_FADV_WILLNEED
+	off_t	fo0 = 0, fo1 = 0;
+	int	fd = -1;
+	BEAMI	*bi;
+					/* coalesce nearby fragments */
+	for ( ; n-- > 0; hb++) {
+		if (hb->h->bl[hb->b] != NULL || !(bi = hb->h->bi + hb->b)->nrd)
+			continue;
+		if (hb->h->fd == fd && bi->fo >= fo0 &&
+				bi->fo <= fo1 + PREFETCHGAP) {
+			if (bi->fo + bi->nrd*sizeof(RAYVAL) > fo1)
+				fo1 = bi->fo + bi->nrd*sizeof(RAYVAL);
+			continue;
+		}
+		if (fd >= 0)		/* kernel reads ahead for us */
+			posix_fadvise(fd, fo0, fo1-fo0, POSIX_FADV_WILLNEED);
+		fd = hb->h->fd;
+		fo0 = bi->fo;
+		fo1 = fo0 + bi->nrd*sizeof(RAYVAL);
+	}
+	if (fd >= 0)
+		posix_fadvise(fd, fo0, fo1-fo0, POSIX_FADV_WILLNEED);
+#endif
+}
+
+
 int
 hdfilord(	/* order beams for quick loading */
 	const void	*hb1,
@@ -549,6 +586,7 @@ hdloadbeams(	/* load a list of beams in optimal order */
 			error(CONSISTENCY, "bad beam in hdloadbeams");
 					/* sort list for optimal access */
 	qsort((void *)hb, n, sizeof(HDBEAMI), hdfilord);
+	hdprefetch(hb, n);		/* start reading non-residents */
 	bytesloaded = 0;		/* run through loaded beams */
 	for ( ; n && (bp = hb->h->bl[hb->b]) != NULL; n--, hb++) {
 		bp->tick = hdclock;	/* preempt swap */
@@ -36,7 +36,7 @@ int	NVARS = NRHVARS;		/* total number of variables */
 
 VARIABLE	vv[] = RHVINIT;		/* variable-value pairs */
 
-char	*progname;		/* our program name */
+extern char	*progname;	/* our program name */
 char	*hdkfile;		/* holodeck file name */
 char	froot[256];		/* root file name */
 
@@ -105,6 +105,9 @@ main(
 		case 'i':			/* read input from stdin */
 			readinp++;
 			break;
+		case 's':			/* shared-memory workers */
+			shmtrace++;
+			break;
 		case 'n':			/* compute processes */
 			if (i >= argc-2)
 				goto userr;
@@ -164,7 +167,7 @@ main(
 	quit(0);
 userr:
 	fprintf(stderr,
-"Usage: %s [-n nprocs][-o disp][-i][-w][-r|-f] output.hdk [control.hif|+|- [VAR=val ..]]\n",
+"Usage: %s [-n nprocs][-s][-o disp][-i][-w][-r|-f] output.hdk [control.hif|+|- [VAR=val ..]]\n",
 			progname);
 	quit(1);
 	return 1; /* pro forma return */
@@ -657,6 +660,8 @@ int	ec;
 {
 	int	status = 0;
 
+	if (nprocs < 0)			/* shared-memory worker */
+		_exit(ec);
 	if (hdlist[0] != NULL) {	/* close holodeck */
 		if (nprocs > 0)
 			status = done_rtrace();		/* calls hdsync() */
@@ -133,6 +133,12 @@ extern int start_rtrace(void);
 extern int end_rtrace(void);
 extern PACKET *do_packets(PACKET *pl);
 extern PACKET *flush_queue(void);
+	/* rholo2s.c */
+extern int shmtrace;
+extern int start_shmtrace(void);
+extern int end_shmtrace(void);
+extern PACKET *do_shmpackets(PACKET *pl);
+extern PACKET *flush_shmqueue(void);
 	/* rholo3.c */
 extern void init_global(void);
 extern int next_packet(PACKET *p, int	n);
@@ -43,6 +43,9 @@ start_rtrace(void)			/* start rtrace process */
 	static char	buf1[8];
 	int	rmaxpack = 0;
 	int	psiz, n;
+
+	if (shmtrace)			/* forked rholo workers? */
+		return(start_shmtrace());
 					/* get number of processes */
 	if (ncprocs <= 0 || nprocs > 0)
 		return(0);
@@ -246,6 +249,9 @@ do_packets(			/* queue a packet list, return finished */
 )
 {
 	PACKET	*p;
+
+	if (shmtrace)
+		return(do_shmpackets(pl));
 					/* consistency check */
 	if (nprocs < 1)
 		error(CONSISTENCY, "do_packets called with no active process");
@@ -267,6 +273,8 @@ flush_queue(void)			/* empty all rtrace queues */
 	PACKET	*p;
 	int	i, n, nr;
 
+	if (shmtrace)
+		return(flush_shmqueue());
 	for (i = 0; i < nprocs; i++)
 		if (pqlen[i]) {
 			if (rpdone == NULL) {		/* tack on queue */
@@ -322,6 +330,8 @@ end_rtrace(void)			/* close rtrace process(es) */
 {
 	int	status = 0, rv;
 
+	if (shmtrace)
+		return(end_shmtrace());
 	if (nprocs > 1)
 		killpersist();
 	status = close_processes(rtpd, nprocs);
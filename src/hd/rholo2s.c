@@ -0,0 +1,414 @@
+#ifndef lint
+static const char	RCSid[] = "$Id$";
+#endif
+/*
+ * Routines for tracing beams in forked rholo processes
+ *
+ * The octree is loaded here and shared copy-on-write with each worker,
+ * which traces packets from its own ring of slots in anonymous shared
+ * memory.  It is read again on restart if the file has changed.  The
+ * pipes carry one byte per packet to say that a slot is ready, so ray
+ * data is never copied through the kernel.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <string.h>
+
+#include "ray.h"
+#include "ambient.h"
+#undef OCTREE			/* octree.h type, rholo.h variable */
+#include "rholo.h"
+#include "random.h"
+#include "selcall.h"
+#include "rtprocess.h"
+
+#ifndef MAXPROC
+#define MAXPROC		64
+#endif
+#ifndef SHMQLEN
+#define SHMQLEN		16		/* packet slots per worker (< 256) */
+#endif
+
+typedef struct {
+	int	nr;			/* number of rays in packet */
+	float	rod[6*RPACKSIZ];	/* ray origins and directions */
+	float	rvl[4*RPACKSIZ];	/* ray values and lengths */
+} SHMSLOT;
+
+typedef struct {
+	int	pid;			/* worker process id */
+	int	w, r;			/* request and reply pipes */
+	int	next;			/* next slot to fill */
+} SHMPROC;
+
+extern char	*shm_boundary;		/* boundary of shared memory */
+
+int	shmtrace = 0;			/* use shared-memory workers? */
+
+static SHMSLOT	*slots = NULL;		/* shared packet rings */
+static SHMPROC	shp[MAXPROC];		/* worker descriptors */
+
+static PACKET	*pqueue[MAXPROC];	/* packet queues */
+static int	pqlen[MAXPROC];		/* packet queue lengths */
+
+static time_t	scene_date = 0;		/* octree date when loaded */
+
+static void shm_options(void);
+static void shm_worker(int pn);
+static int bestout(void);
+static int slots_avail(void);
+static void queue_packet(PACKET *p);
+static PACKET * take_packets(int pn, int n);
+static PACKET * get_packets(int poll);
+
+
+static void
+shm_options(void)			/* apply rendering options */
+{
+	int	i, rval;
+
+	for (i = 1; i < rtargc; i++) {
+		if (!strcmp(rtargv[i], "-w") || !strcmp(rtargv[i], "-w-") ||
+				!strcmp(rtargv[i], "-w+"))
+			continue;		/* rholo -w has final say */
+		rval = getrenderopt(rtargc-i, rtargv+i);
+		if (rval < 0) {
+			sprintf(errmsg,
+			"rendering option '%s' not supported with -s",
+					rtargv[i]);
+			error(USER, errmsg);
+		}
+		i += rval;
+	}
+	do_irrad = 0;			/* same as rtrace -i- -I- */
+#ifdef ACCELERAD
+	use_optix = 0;			/* workers trace on the CPU */
+#endif
+}
+
+
+int
+start_shmtrace(void)			/* start worker processes */
+{
+	int	p0[2], p1[2];
+	int	pn;
+					/* get number of processes */
+	if (ncprocs <= 0 || nprocs > 0)
+		return(0);
+	if (ncprocs > MAXPROC) {
+		sprintf(errmsg,
+			"number of worker processes reduced from %d to %d",
+				ncprocs, MAXPROC);
+		error(WARNING, errmsg);
+		ncprocs = MAXPROC;
+	}
+	if (scene_date && fdate(vval(OCTREE)) != scene_date) {
+		ray_done(1);		/* octree rebuilt since last start */
+		scene_date = 0;
+	}
+	if (!scene_date) {		/* load the shared scene */
+		if (shm_boundary == NULL) {
+			shm_options();	/* first time only */
+			shm_boundary = (char *)malloc(16);
+			strcpy(shm_boundary, "SHM_BOUNDARY");
+		}
+		ray_init(vval(OCTREE));
+		preload_objs();		/* so workers share it */
+		scene_date = fdate(vval(OCTREE));
+	}
+	ambsync();			/* load any new ambient values */
+	slots = (SHMSLOT *)mmap(NULL, sizeof(SHMSLOT)*SHMQLEN*ncprocs,
+			PROT_READ|PROT_WRITE, MAP_ANON|MAP_SHARED, -1, 0);
+	if (slots == (SHMSLOT *)MAP_FAILED)
+		error(SYSTEM, "cannot map packet slots in start_shmtrace");
+	fflush(NULL);			/* clear pending output */
+	for (nprocs = 0; nprocs < ncprocs; nprocs++) {
+		if (pipe(p0) < 0 || pipe(p1) < 0)
+			error(SYSTEM, "cannot create pipe");
+		if ((shp[nprocs].pid = fork()) == 0) {
+			for (pn = nprocs; pn--; ) {
+				close(shp[pn].w);
+				close(shp[pn].r);
+			}
+			close(p0[1]); close(p1[0]);
+			close(0);	/* don't share stdin */
+			if (rand_samp)	/* own primary ray streams */
+				rayseed();
+			RS_INIT();	/* own statistics */
+			shp[nprocs].w = p1[1];
+			shp[nprocs].r = p0[0];
+			shm_worker(nprocs);	/* never returns */
+		}
+		if (shp[nprocs].pid < 0)
+			error(SYSTEM, "cannot fork worker process");
+		close(p0[0]); close(p1[1]);
+		if (rand_samp)		/* decorrelate random sequence */
+			srandom(random());
+		else
+			samplendx++;
+		fcntl(p0[1], F_SETFD, FD_CLOEXEC);
+		fcntl(p1[0], F_SETFD, FD_CLOEXEC);
+		shp[nprocs].w = p0[1];
+		shp[nprocs].r = p1[0];
+		shp[nprocs].next = 0;
+		pqueue[nprocs] = NULL;
+		pqlen[nprocs] = 0;
+	}
+	return(nprocs*SHMQLEN);
+}
+
+
+static void
+shm_worker(			/* trace packets as they come (never returns) */
+	int	pn
+)
+{
+	SHMSLOT	*ring = slots + pn*SHMQLEN;
+	int	vdist = vbool(VDIST);
+	char	buf[SHMQLEN];
+	SHMSLOT	*sp;
+	RAY	myRay;
+	int	n, i, j, k = 0;
+					/* flag worker for quit() */
+	nprocs = -1;
+	while ((n = read(shp[pn].r, buf, sizeof(buf))) > 0)
+		for (j = 0; j < n; j++) {
+			sp = ring + k;
+			for (i = 0; i < sp->nr; i++) {
+				VCOPY(myRay.rorg, sp->rod+6*i);
+				VCOPY(myRay.rdir, sp->rod+6*i+3);
+				if (normalize(myRay.rdir) == 0.0) {
+					memset(sp->rvl+4*i, 0, 4*sizeof(float));
+					continue;
+				}
+				myRay.rmax = 0.0;	/* same as -ld- */
+				ray_trace(&myRay);
+				sp->rvl[4*i] = colval(myRay.rcol,RED);
+				sp->rvl[4*i+1] = colval(myRay.rcol,GRN);
+				sp->rvl[4*i+2] = colval(myRay.rcol,BLU);
+				sp->rvl[4*i+3] = vdist ? raydistance(&myRay)
+							: myRay.rot;
+			}
+			if (writebuf(shp[pn].w, buf+j, 1) != 1)
+				error(SYSTEM, "write error in shm_worker");
+			k = (k+1) % SHMQLEN;
+		}
+	if (n < 0)
+		error(SYSTEM, "read error in shm_worker");
+	ambsync();
+	RS_REPORT();			/* statistics, if enabled */
+	_exit(0);
+}
+
+
+static int
+bestout(void)			/* get best process to process packet */
+{
+	int	cnt;
+	int	pn, i;
+
+	pn = 0;			/* find shortest queue */
+	for (i = 1; i < nprocs; i++)
+		if (pqlen[i] < pqlen[pn])
+			pn = i;
+				/* sanity check */
+	if (pqlen[pn] == SHMQLEN)
+		return(-1);
+	cnt = 0;		/* count number of ties */
+	for (i = pn; i < nprocs; i++)
+		if (pqlen[i] == pqlen[pn])
+			cnt++;
+				/* break ties fairly */
+	if ((cnt = random() % cnt))
+		for (i = pn; i < nprocs; i++)
+			if (pqlen[i] == pqlen[pn] && !cnt--)
+				return(i);
+	return(pn);
+}
+
+
+static int
+slots_avail(void)			/* count packet slots available */
+{
+	int	nslots = 0;
+	int	i;
+
+	for (i = nprocs; i--; )
+		nslots += SHMQLEN - pqlen[i];
+	return(nslots);
+}
+
+
+static void
+queue_packet(			/* put packet in a worker's ring */
+	PACKET	*p
+)
+{
+	SHMSLOT	*sp;
+	char	c = 0;
+	int	pn;
+				/* determine process to give it to */
+	if ((pn = bestout()) < 0)
+		error(INTERNAL, "worker packet rings are full!");
+	sp = slots + pn*SHMQLEN + shp[pn].next;
+	shp[pn].next = (shp[pn].next + 1) % SHMQLEN;
+	packrays(sp->rod, p);
+	sp->nr = p->nr;
+	if (writebuf(shp[pn].w, &c, 1) != 1)
+		error(SYSTEM, "write error in queue_packet");
+	p->next = NULL;
+	if (!pqlen[pn]++)	/* add it to the end of the queue */
+		pqueue[pn] = p;
+	else {
+		PACKET	*rpl = pqueue[pn];
+		while (rpl->next != NULL)
+			rpl = rpl->next;
+		rpl->next = p;
+	}
+}
+
+
+static PACKET *
+take_packets(			/* finish first n packets in worker queue */
+	int	pn,
+	int	n
+)
+{
+	PACKET	*pldone, *p;
+	int	k;
+					/* oldest slot in ring */
+	k = (shp[pn].next - pqlen[pn] + SHMQLEN) % SHMQLEN;
+	pldone = p = pqueue[pn];
+	while (n-- > 0) {
+		donerays(p, slots[pn*SHMQLEN + k].rvl);
+		k = (k+1) % SHMQLEN;
+		pqlen[pn]--;
+		if (!n) {
+			pqueue[pn] = p->next;
+			p->next = NULL;
+		} else
+			p = p->next;
+	}
+	return(pldone);
+}
+
+
+static PACKET *
+get_packets(		/* get finished packets from workers */
+	int	poll
+)
+{
+	static struct timeval	tpoll;	/* zero timeval struct */
+	char	buf[SHMQLEN];
+	fd_set	readset, errset;
+	PACKET	*pldone = NULL, *plend;
+	int	n, pn;
+					/* prepare select call */
+	FD_ZERO(&readset); FD_ZERO(&errset); n = 0;
+	for (pn = nprocs; pn--; ) {
+		if (pqlen[pn])
+			FD_SET(shp[pn].r, &readset);
+		FD_SET(shp[pn].r, &errset);
+		if (shp[pn].r >= n)
+			n = shp[pn].r + 1;
+	}
+					/* make the call */
+	n = select(n, &readset, (fd_set *)NULL, &errset,
+			poll ? &tpoll : (struct timeval *)NULL);
+	if (n < 0) {
+		if (errno == EINTR)	/* interrupted select call */
+			return(NULL);
+		error(SYSTEM, "select call failure in get_packets");
+	}
+	if (n == 0)			/* is nothing ready? */
+		return(NULL);
+	for (pn = 0; pn < nprocs; pn++) {
+		if (!FD_ISSET(shp[pn].r, &readset) &&
+				!FD_ISSET(shp[pn].r, &errset))
+			continue;
+	reread:
+		n = read(shp[pn].r, buf, pqlen[pn]);
+		if (n < 0) {
+			if ((errno == EINTR) | (errno == EAGAIN))
+				goto reread;
+			error(SYSTEM, "read error in get_packets");
+		}
+		if (n == 0)
+			error(USER, "worker process died");
+		if (pldone == NULL)
+			pldone = plend = take_packets(pn, n);
+		else
+			plend->next = take_packets(pn, n);
+		while (plend->next != NULL)
+			plend = plend->next;
+	}
+	return(pldone);			/* return finished packets */
+}
+
+
+PACKET *
+do_shmpackets(			/* queue a packet list, return finished */
+	PACKET	*pl
+)
+{
+	PACKET	*p;
+					/* consistency check */
+	if (nprocs < 1)
+		error(CONSISTENCY, "do_shmpackets called with no active process");
+					/* queue each new packet */
+	while (pl != NULL) {
+		p = pl; pl = p->next; p->next = NULL;
+		queue_packet(p);
+	}
+	return(get_packets(slots_avail()));	/* return processed packets */
+}
+
+
+PACKET *
+flush_shmqueue(void)			/* wait for all worker queues */
+{
+	char	buf[SHMQLEN];
+	PACKET	*rpdone = NULL, *rpl;
+	int	pn, n;
+
+	for (pn = 0; pn < nprocs; pn++) {
+		if (!(n = pqlen[pn]))
+			continue;
+		if (readbuf(shp[pn].r, buf, n) != n)
+			error(USER, "worker process died");
+		if (rpdone == NULL)
+			rpdone = rpl = take_packets(pn, n);
+		else
+			rpl->next = take_packets(pn, n);
+		while (rpl->next != NULL)
+			rpl = rpl->next;
+	}
+	return(rpdone);		/* return all packets completed */
+}
+
+
+int
+end_shmtrace(void)			/* close worker processes */
+{
+	int	status = 0, st;
+	int	pn;
+
+	for (pn = nprocs; pn--; )
+		close(shp[pn].w);	/* workers exit on EOF */
+	for (pn = nprocs; pn--; ) {
+		close(shp[pn].r);
+		if (waitpid(shp[pn].pid, &st, 0) < 0 || st)
+			status = 1;
+		pqueue[pn] = NULL;
+		pqlen[pn] = 0;
+	}
+	if (slots != NULL)
+		munmap((void *)slots, sizeof(SHMSLOT)*SHMQLEN*nprocs);
+	slots = NULL;
+	nprocs = 0;
+	ambsync();			/* pick up workers' values */
+	return(status);
+}
@@ -15,6 +15,10 @@ static const char	RCSid[] = "$Id: rholo3.c,v 3.44 2018/10/05 19:19:16 greg Exp $
 #define MAXADISK	10240.	/* maximum holodeck size (Megs) for ambient */
 #endif
 
+#ifndef NPREFETCH
+#define NPREFETCH	128	/* beams to read ahead in compute list */
+#endif
+
 #ifndef abs
 #define abs(x)		((x) > 0 ? (x) : -(x))
 #endif
@@ -37,6 +41,7 @@ static void view_list(FILE	*fp);
 static void ambient_list(void);
 static double beamvolume(HOLO	*hp, int	bi);
 static void dispbeam(BEAM	*b, HDBEAMI	*hb);
+static void prefetch(void);
 
 
 
@@ -437,6 +442,22 @@ sortcomplist(void)			/* fix our list order */
 }
 
 
+static void
+prefetch(void)			/* start reading beams coming up in list */
+{
+	HDBEAMI	hb[NPREFETCH];
+	int	i, n;
+
+	if ((n = complen - listpos) > NPREFETCH)
+		n = NPREFETCH;
+	for (i = n; i--; ) {
+		hb[i].h = hdlist[complist[listpos+i].hd];
+		hb[i].b = complist[listpos+i].bi;
+	}
+	hdprefetch(hb, n);
+}
+
+
 /*
  * The following routine works on the assumption that the bundle weights are
  * more or less evenly distributed, such that computing a packet causes
@@ -456,6 +477,8 @@ next_packet(		/* prepare packet for computation */
 		sortcomplist();
 	if (complen <= 0)
 		return(0);
+	if (!(listpos % NPREFETCH))	/* read ahead of compute order */
+		prefetch();
 	p->hd = complist[listpos].hd;
 	p->bi = complist[listpos].bi;
 	p->nc = complist[listpos].nc;
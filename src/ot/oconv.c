@@ -51,6 +51,7 @@ main(		/* convert object files to an octree */
 	char  *infile = NULL;
 	int  inpfrozen = 0;
 	int  outflags = IO_ALL;
+	int  nproc = 1;
 	OBJECT	startobj;
 	int  i;
 
@@ -83,6 +84,9 @@ main(		/* convert object files to an octree */
 		case 'w':				/* supress warnings */
 			nowarn = 1;
 			break;
+		case 'N':				/* parallel commands */
+			nproc = atoi(argv[++i]);
+			break;
 		default:
 			sprintf(errmsg, "unknown option: '%s'", argv[i]);
 			error(USER, errmsg);
@@ -104,6 +108,9 @@ breakopt:
 
 	startobj = nobjects;		/* previous objects already converted */
 
+	if (nproc > 1)			/* run scene commands ahead */
+		spoolobj(argv+i, argc-i, nproc);
+
 	for ( ; i < argc; i++)		/* read new scene descriptions */
 		if (!strcmp(argv[i], "-")) {	/* from stdin */
 			readobj(NULL);
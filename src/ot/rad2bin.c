@@ -0,0 +1,244 @@
+#ifndef lint
+static const char	RCSid[] = "$Id$";
+#endif
+/*
+ *  rad2bin.c - convert Radiance scene files to and from binary form.
+ *
+ *  Objects and commands are carried over as they are, so that loading
+ *  the binary scene has the same effect as loading the text.
+ */
+
+#include  <ctype.h>
+
+#include  "platform.h"
+#include  "standard.h"
+#include  "octree.h"
+#include  "object.h"
+#include  "otypes.h"
+
+char  *progname;			/* argv[0] */
+
+int  expand = 0;			/* run commands during conversion? */
+
+void  (*addobjnotify[])() = {NULL};	/* new object notifier functions */
+
+static bsc_cbfunc  *putfunc;		/* output for each object */
+
+static void convert(char *inpspec);
+static void getobjtext(char *name, FILE *fp);
+static void putbin(char *mod, OBJREC *o);
+static void puttxt(char *mod, OBJREC *o);
+
+
+static void
+putbin(			/* write object or command in binary */
+	char  *mod,
+	OBJREC  *o
+)
+{
+	if (o == NULL && expand) {
+		convert(mod);
+		return;
+	}
+	putbscene(mod, o, stdout);
+	if (o != NULL)
+		freefargs(&o->oargs);
+}
+
+
+static void
+puttxt(			/* write object or command as text */
+	char  *mod,
+	OBJREC  *o
+)
+{
+	int  i;
+
+	if (o == NULL) {
+		if (expand)
+			convert(mod);
+		else
+			printf("\n%s\n", mod);
+		return;
+	}
+	putchar('\n');
+	fputword(mod, stdout);
+	printf(" %s ", ofun[o->otype].funame);
+	fputword(o->oname, stdout);
+	if (o->otype == MOD_ALIAS) {
+		putchar(' ');
+		fputword(o->oargs.sarg[0], stdout);
+		putchar('\n');
+		freefargs(&o->oargs);
+		return;
+	}
+	printf("\n%d", o->oargs.nsargs);
+	for (i = 0; i < o->oargs.nsargs; i++) {
+		putchar(' ');
+		fputword(o->oargs.sarg[i], stdout);
+	}
+#ifdef  IARGS
+	printf("\n%d", o->oargs.niargs);
+	for (i = 0; i < o->oargs.niargs; i++)
+		printf(" %ld", o->oargs.iarg[i]);
+#else
+	printf("\n0");
+#endif
+	printf("\n%d", o->oargs.nfargs);
+	for (i = 0; i < o->oargs.nfargs; i++)
+		printf(" %.17g", o->oargs.farg[i]);
+	putchar('\n');
+	freefargs(&o->oargs);
+}
+
+
+static void
+getobjtext(			/* read the next text object */
+	char  *name,
+	FILE  *fp
+)
+{
+	char  mod[MAXSTR], sbuf[MAXSTR];
+	OBJREC  thisobj;
+	int  rval;
+					/* get modifier */
+	strcpy(mod, "EOF");
+	fgetword(mod, MAXSTR, fp);
+					/* get type */
+	strcpy(sbuf, "EOF");
+	fgetword(sbuf, MAXSTR, fp);
+	if ((thisobj.otype = otype(sbuf)) < 0) {
+		sprintf(errmsg, "(%s): unknown type \"%s\"", name, sbuf);
+		error(USER, errmsg);
+	}
+					/* get identifier */
+	sbuf[0] = '\0';
+	fgetword(sbuf, MAXSTR, fp);
+	thisobj.oname = savqstr(sbuf);
+	thisobj.omod = OVOID;
+	thisobj.os = NULL;
+					/* get arguments */
+	memset(&thisobj.oargs, 0, sizeof(FUNARGS));
+	if (thisobj.otype == MOD_ALIAS) {
+		strcpy(sbuf, "EOF");
+		fgetword(sbuf, MAXSTR, fp);
+		thisobj.oargs.sarg = (char **)malloc(sizeof(char *));
+		if (thisobj.oargs.sarg == NULL)
+			error(SYSTEM, "out of memory in getobjtext");
+		thisobj.oargs.nsargs = 1;
+		thisobj.oargs.sarg[0] = savestr(sbuf);
+	} else if ((rval = readfargs(&thisobj.oargs, fp)) == 0) {
+		sprintf(errmsg, "(%s): bad arguments", name);
+		objerror(&thisobj, USER, errmsg);
+	} else if (rval < 0) {
+		sprintf(errmsg, "(%s): error reading scene", name);
+		error(SYSTEM, errmsg);
+	}
+	(*putfunc)(mod, &thisobj);
+	freeqstr(thisobj.oname);
+}
+
+
+static void
+convert(			/* convert a scene file or stream */
+	char  *inpspec
+)
+{
+	FILE  *infp;
+	char  buf[2048];
+	int  c;
+
+	if (inpspec == NULL) {
+		infp = stdin;
+		inpspec = "standard input";
+	} else if (inpspec[0] == '!') {
+		if ((infp = popen(inpspec+1, "r")) == NULL) {
+			sprintf(errmsg, "cannot execute \"%s\"", inpspec);
+			error(SYSTEM, errmsg);
+		}
+	} else if ((infp = fopen(inpspec, "r")) == NULL) {
+		sprintf(errmsg, "cannot open scene file \"%s\"", inpspec);
+		error(SYSTEM, errmsg);
+	}
+	SET_FILE_BINARY(infp);
+	if ((c = getc(infp)) == '#') {
+		if ((c = getc(infp)) == '?')	/* binary scene */
+			readbscene(inpspec, infp, putfunc);
+		else if (c != '\n')		/* comment */
+			fgets(buf, sizeof(buf), infp);
+	} else if (c != EOF)
+		ungetc(c, infp);
+	while ((c = getc(infp)) != EOF) {
+		if (isspace(c))
+			continue;
+		if (c == '#') {				/* comment */
+			fgets(buf, sizeof(buf), infp);
+		} else if (c == '!') {			/* command */
+			ungetc(c, infp);
+			fgetline(buf, sizeof(buf), infp);
+			(*putfunc)(buf, NULL);
+		} else {				/* object */
+			ungetc(c, infp);
+			getobjtext(inpspec, infp);
+		}
+	}
+	if (inpspec[0] == '!')
+		pclose(infp);
+	else if (infp != stdin)
+		fclose(infp);
+}
+
+
+int
+main(		/* convert scene files to or from binary */
+	int  argc,
+	char  **argv
+)
+{
+	int  tobinary = 1;
+	int  i;
+
+	progname = argv[0];
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		switch (argv[i][1]) {
+		case 'r':
+			tobinary = 0;
+			continue;
+		case 'e':
+			expand = 1;
+			continue;
+		}
+		sprintf(errmsg, "command line error at '%s'", argv[i]);
+		error(USER, errmsg);
+	}
+	if (tobinary) {
+		putfunc = putbin;
+		SET_FILE_BINARY(stdout);
+		newheader("RADIANCE", stdout);
+		printargs(argc, argv, stdout);
+		fputendian(stdout);
+		fputformat(SCENEFMT, stdout);
+		putchar('\n');
+		beginbscene(stdout);
+	} else {
+		putfunc = puttxt;
+		printf("# ");
+		printargs(argc, argv, stdout);
+	}
+						/* convert input */
+	if (i >= argc)
+		convert(NULL);
+	else
+		for ( ; i < argc; i++)
+			if (!strcmp(argv[i], "-"))	/* from stdin */
+				convert(NULL);
+			else				/* from file */
+				convert(argv[i]);
+	if (tobinary)
+		endbscene(stdout);
+	if (fflush(stdout) == EOF)
+		error(SYSTEM, "write error");
+	quit(0);
+	return 0; /* pro forma return */
+}
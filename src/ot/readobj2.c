@@ -19,6 +19,9 @@ static const char	RCSid[] = "$Id: readobj2.c,v 2.11 2016/02/02 18:02:32 greg Exp
 
 
 static void getobject2(char  *name, FILE  *fp, ro_cbfunc f);
+static void getbscobj2(char  *mod, OBJREC  *o);
+
+static ro_cbfunc  *bscfunc;		/* callback for binary scene */
 
 
 void
@@ -44,6 +47,16 @@ readobj2(	/* read in an object file or stream */
 		sprintf(errmsg, "cannot open scene file \"%s\"", input);
 		error(SYSTEM, errmsg);
 	}
+	if ((c = getc(infp)) == '#') {
+		if ((c = getc(infp)) == '?') {	/* binary scene */
+			ro_cbfunc  *oldfunc = bscfunc;
+			bscfunc = callback;
+			readbscene(input, infp, getbscobj2);
+			bscfunc = oldfunc;
+		} else if (c != '\n')		/* comment */
+			fgets(buf, sizeof(buf), infp);
+	} else if (c != EOF)
+		ungetc(c, infp);
 	while ((c = getc(infp)) != EOF) {
 		if (isspace(c))
 			continue;
@@ -102,3 +115,20 @@ getobject2(			/* read the next object */
 	freefargs(&thisobj.oargs);
 	free_os(&thisobj);
 }
+
+
+static void
+getbscobj2(			/* pass on object from binary scene */
+	char  *mod,
+	OBJREC  *o
+)
+{
+	if (o == NULL) {			/* command */
+		readobj2(mod, bscfunc);
+		return;
+	}
+	if (o->otype != MOD_ALIAS)
+		(*bscfunc)(o);
+	freefargs(&o->oargs);
+	free_os(o);
+}
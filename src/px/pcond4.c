@@ -78,9 +78,8 @@ compraydir(void)				/* compute ray directions */
 void
 compveil(void)				/* compute veiling image */
 {
-	double	t2, t2sum;
-	COLOR	ctmp, vsum;
-	int	px, py;
+	double	t2, (*vsum)[4];
+	int	npix, p, q;
 	int	x, y;
 
 	if (veilimg != NULL)		/* already done? */
@@ -89,33 +88,40 @@ compveil(void)				/* compute veiling image */
 	compraydir();
 					/* compute veil image */
 	veilimg = (COLOR *)malloc(fvxr*fvyr*sizeof(COLOR));
-	if (veilimg == NULL)
+	npix = fvxr*fvyr;		/* weighted sums and weight totals */
+	vsum = (double (*)[4])calloc(npix, sizeof(double [4]));
+	if ((veilimg == NULL) | (vsum == NULL))
 		syserror("malloc");
-	for (py = 0; py < fvyr; py++)
-		for (px = 0; px < fvxr; px++) {
-			t2sum = 0.;
-			setcolor(vsum, 0., 0., 0.);
-			for (y = 0; y < fvyr; y++)
-				for (x = 0; x < fvxr; x++) {
-					if (x == px && y == py) continue;
-					t2 = DOT(rdirscan(py)[px],
-							rdirscan(y)[x]);
-					if (t2 <= FTINY) continue;
-					/*	use approximation instead
-					t3 = acos(t2);
-					t2 = t2/(t3*t3);
-					*/
-					t2 *= .5 / (1. - t2);
-					copycolor(ctmp, fovscan(y)[x]);
-					scalecolor(ctmp, t2);
-					addcolor(vsum, ctmp);
-					t2sum += t2;
-				}
-			/* VADAPT of original is subtracted in addveil() */
-			if (t2sum > FTINY)
-				scalecolor(vsum, VADAPT/t2sum);
-			copycolor(veilscan(py)[px], vsum);
+	/*
+	 * The scattering weight is symmetric in the two directions,
+	 * so each pair of samples is visited once and contributes
+	 * to the veil at both ends.
+	 */
+	for (p = 0; p < npix; p++)
+		for (q = p+1; q < npix; q++) {
+			t2 = DOT(raydir[p], raydir[q]);
+			if (t2 <= FTINY) continue;
+			/*	use approximation instead
+			t3 = acos(t2);
+			t2 = t2/(t3*t3);
+			*/
+			t2 *= .5 / (1. - t2);
+			vsum[p][RED] += t2*fovimg[q][RED];
+			vsum[p][GRN] += t2*fovimg[q][GRN];
+			vsum[p][BLU] += t2*fovimg[q][BLU];
+			vsum[p][3] += t2;
+			vsum[q][RED] += t2*fovimg[p][RED];
+			vsum[q][GRN] += t2*fovimg[p][GRN];
+			vsum[q][BLU] += t2*fovimg[p][BLU];
+			vsum[q][3] += t2;
 		}
+	for (p = 0; p < npix; p++) {
+		/* VADAPT of original is subtracted in addveil() */
+		t2 = vsum[p][3] > FTINY ? VADAPT/vsum[p][3] : 1.;
+		setcolor(veilimg[p], t2*vsum[p][RED], t2*vsum[p][GRN],
+				t2*vsum[p][BLU]);
+	}
+	free((void *)vsum);
 					/* modify FOV sample image */
 	for (y = 0; y < fvyr; y++)
 		for (x = 0; x < fvxr; x++) {
@@ -13,6 +13,9 @@ static const char	RCSid[] = "$Id: pinterp.c,v 2.49 2020/02/28 05:18:49 greg Exp
 #include <string.h>
 
 #include "platform.h"
+#ifdef RHAS_FORK_EXEC
+#include <sys/wait.h>
+#endif
 #include "standard.h"
 #include "rtprocess.h" /* Windows: must come before color.h */
 #include "view.h"
@@ -48,6 +51,18 @@ struct position {int x,y; float z;};
 
 struct bound {int min,max;};
 
+typedef struct {
+	char	*pfile;			/* picture file name */
+	char	*hdr;			/* saved header lines */
+	int	hdrlen;			/* length of saved header */
+	VIEW	vw;			/* picture view */
+	RESOLU	rs;			/* picture resolution */
+	double	expos;			/* picture exposure */
+	COLR	*pix;			/* picture, in scanline order */
+	float	*zbuf;			/* z values (one scan if constant) */
+	int	zstride;		/* z values per scan (0 if constant) */
+} SRCPICT;			/* input picture held in memory */
+
 VIEW	ourview = STDVIEW;		/* desired view */
 int	hresolu = 512;			/* horizontal resolution */
 int	vresolu = 512;			/* vertical resolution */
@@ -85,6 +100,9 @@ double	theirexp;			/* input picture exposure */
 MAT4	theirs2ours;			/* transformation matrix */
 int	hasmatrix = 0;			/* has transformation matrix */
 
+SRCPICT	*srcpict;			/* loaded input pictures */
+int	nsrcpicts = 0;			/* number of input pictures */
+
 static SUBPROC PDesc = SP_INACTIVE; /* rtrace process descriptor */
 unsigned short	queue[PACKSIZ][2];	/* pending pixels */
 int	packsiz;			/* actual packet size */
@@ -95,14 +113,18 @@ typedef void fillfunc_t(int x, int y);
 static gethfunc headline;
 static int nextview(FILE *fp);
 static void compavgview(void);
-static void addpicture(char *pfile, char *zspec);
+static void loadpicture(SRCPICT *sp, char *pfile, char *zspec);
+static void allocframe(int doavg, int doblur);
+static void freeframe(void);
+static void dopicture(int ac, char *av[], int putview, char *zfile);
+static void addpicture(SRCPICT *sp);
 static int pixform(MAT4 xfmat, VIEW *vw1, VIEW *vw2);
 static void addscanline(struct bound *xl, int y,
 	COLR *pline, float *zline, struct position *lasty);
 static void addpixel(struct position *p0, struct position *p1,
 	struct position *p2, COLR pix, double w, double z);
 static double movepixel(FVECT pos);
-static int getperim(struct bound *xl, struct bound *yl, float *zline, int zfd);
+static int getperim(struct bound *xl, struct bound *yl, SRCPICT *sp);
 static void backpicture(fillfunc_t *fill, int samp);
 static void fillpicture(fillfunc_t *fill);
 static int clipaft(void);
@@ -132,6 +154,10 @@ main(			/* interpolate pictures */
 	int	doblur = 0;
 	char	*zfile = NULL;
 	char	*expcomp = NULL;
+	char	*outspec = NULL;
+	char	*calargs = NULL;
+	int	seqstart = 0;
+	int	nproc = 1;
 	int	i, an, rval;
 
         SET_DEFAULT_BINARY();
@@ -210,7 +236,7 @@ main(			/* interpolate pictures */
 			case 'r':				/* rtrace */
 				check(3,"s");
 				fillfunc = rcalfill;
-				calstart(RTCOM, argv[++an]);
+				calargs = argv[++an];
 				break;
 			default:
 				goto badopt;
@@ -220,6 +246,18 @@ main(			/* interpolate pictures */
 			check(2,"s");
 			zfile = argv[++an];
 			break;
+		case 'o':				/* output file */
+			check(2,"s");
+			outspec = argv[++an];
+			break;
+		case 'S':				/* sequence start */
+			check(2,"i");
+			seqstart = atoi(argv[++an]);
+			break;
+		case 'N':				/* number of processes */
+			check(2,"i");
+			nproc = atoi(argv[++an]);
+			break;
 		case 'x':				/* x resolution */
 			check(2,"i");
 			hresolu = atoi(argv[++an]);
@@ -276,6 +314,108 @@ main(			/* interpolate pictures */
 			if (!(doavg | doblur))
 				rexpadj = pow(2.0, (double)expadj);
 		}
+	}
+	if (seqstart > 0) {
+		if (outspec == NULL) {
+			fprintf(stderr, "%s: -S option requires -o\n",
+					progname);
+			exit(1);
+		}
+		if (doblur) {
+			fprintf(stderr, "%s: -B option incompatible with -S\n",
+					progname);
+			exit(1);
+		}
+	}
+#ifndef RHAS_FORK_EXEC
+	nproc = 1;
+#endif
+	if (nproc < 1)
+		nproc = 1;
+						/* load input pictures */
+	nsrcpicts = (argc-an)/2;
+	srcpict = (SRCPICT *)malloc(nsrcpicts*sizeof(SRCPICT));
+	if (srcpict == NULL)
+		syserror(progname);
+	for (i = 0; i < nsrcpicts; i++)
+		loadpicture(&srcpict[i], argv[an+2*i], argv[an+2*i+1]);
+	if (seqstart > 0) {			/* render sequence */
+		VIEW	*seqview = NULL;
+		int	nseq = 0;
+		int	hres0 = hresolu, vres0 = vresolu;
+		double	pa0 = pixaspect;
+		char	linebuf[256], fname[256], zname[256];
+		int	kid = 0, status;
+		/*
+		 * Views are read up front and divided among nproc
+		 * processes, which share the loaded pictures.
+		 */
+		while (fgets(linebuf, sizeof(linebuf), stdin) != NULL) {
+			if (!isview(linebuf))
+				continue;
+			seqview = (VIEW *)realloc((void *)seqview,
+					(nseq+1)*sizeof(VIEW));
+			if (seqview == NULL)
+				syserror(progname);
+			seqview[nseq] = nseq ? seqview[nseq-1] : ourview;
+			if (sscanview(&seqview[nseq], linebuf) > 0)
+				nseq++;
+		}
+		if (!nseq) {
+			fprintf(stderr, "%s: no view on standard input!\n",
+					progname);
+			exit(1);
+		}
+		if (nproc > nseq)
+			nproc = nseq;
+#ifdef RHAS_FORK_EXEC
+		fflush(stdout);
+		while (++kid < nproc) {		/* fork helpers */
+			RT_PID	pid = fork();
+			if (pid == 0)
+				break;
+			if (pid < 0)
+				syserror("fork");
+		}
+		if (kid >= nproc)		/* parent does frame 0 */
+			kid = 0;
+#endif
+		if (calargs != NULL)
+			calstart(RTCOM, calargs);
+		for (i = kid; i < nseq; i += nproc) {
+			ourview = seqview[i];
+			nvavg = 0;
+			nextview(NULL);
+			hresolu = hres0; vresolu = vres0; pixaspect = pa0;
+			normaspect(viewaspect(&ourview), &pixaspect,
+					&hresolu, &vresolu);
+			allocframe(doavg, 0);
+			if (snprintf(fname, sizeof(fname), outspec,
+					seqstart+i) >= (int)sizeof(fname))
+				error(USER, "output file name too long");
+			if (freopen(fname, "w", stdout) == NULL)
+				syserror(fname);
+			SET_FILE_BINARY(stdout);
+			if (zfile != NULL)
+				if (snprintf(zname, sizeof(zname), zfile,
+						seqstart+i) >= (int)sizeof(zname))
+					error(USER, "z-file name too long");
+			ourexp = -1;
+			dopicture(argc, argv, 1, zfile==NULL ? NULL : zname);
+			if (fflush(stdout) == EOF)
+				syserror(fname);
+			freeframe();
+		}
+		caldone();
+		if (kid)			/* helper is done */
+			exit(0);
+		rval = 0;			/* else wait for helpers */
+#ifdef RHAS_FORK_EXEC
+		while (wait(&status) != -1)
+			if (!rval)
+				rval = status>>8 & 0xff;
+#endif
+		exit(rval);
 	}
 						/* set view */
 	if (nextview(doblur ? stdin : (FILE *)NULL) == EOF) {
@@ -284,33 +424,88 @@ main(			/* interpolate pictures */
 		exit(1);
 	}
 	normaspect(viewaspect(&ourview), &pixaspect, &hresolu, &vresolu);
-						/* allocate frame */
+	allocframe(doavg, doblur);
+	if (outspec != NULL && freopen(outspec, "w", stdout) == NULL)
+		syserror(outspec);
+	SET_FILE_BINARY(stdout);
+	if (calargs != NULL)
+		calstart(RTCOM, calargs);
+	dopicture(argc, argv, doblur | gotvfile, zfile);
+	caldone();				/* close calculation */
+	exit(0);
+userr:
+	fprintf(stderr,
+	"Usage: %s [view opts][-t eps][-z zout][-o out][-S start][-N nproc][-e spec][-B][-a|-q][-fT][-n] pfile zspec ..\n",
+			progname);
+	exit(1);
+#undef check
+}
+
+
+static void
+allocframe(			/* allocate output frame buffers */
+	int	doavg,
+	int	doblur
+)
+{
 	if (doavg) {
-		ourspict = (COLOR *)bmalloc(hresolu*vresolu*sizeof(COLOR));
-		ourweigh = (float *)bmalloc(hresolu*vresolu*sizeof(float));
+		ourspict = (COLOR *)malloc(hresolu*vresolu*sizeof(COLOR));
+		ourweigh = (float *)malloc(hresolu*vresolu*sizeof(float));
 		if ((ourspict == NULL) | (ourweigh == NULL))
 			syserror(progname);
 	} else {
-		ourpict = (COLR *)bmalloc(hresolu*vresolu*sizeof(COLR));
+		ourpict = (COLR *)malloc(hresolu*vresolu*sizeof(COLR));
 		if (ourpict == NULL)
 			syserror(progname);
 	}
 	if (doblur) {
-		ourbpict = (COLOR *)bmalloc(hresolu*vresolu*sizeof(COLOR));
+		ourbpict = (COLOR *)malloc(hresolu*vresolu*sizeof(COLOR));
 		if (ourbpict == NULL)
 			syserror(progname);
 	}
-	ourzbuf = (float *)bmalloc(hresolu*vresolu*sizeof(float));
+	ourzbuf = (float *)malloc(hresolu*vresolu*sizeof(float));
 	if (ourzbuf == NULL)
 		syserror(progname);
+}
+
+
+static void
+freeframe(void)			/* free output frame buffers */
+{
+	if (averaging) {
+		free((void *)ourspict);
+		free((void *)ourweigh);
+		ourspict = NULL; ourweigh = NULL;
+	} else {
+		free((void *)ourpict);
+		ourpict = NULL;
+	}
+	if (blurring) {
+		free((void *)ourbpict);
+		ourbpict = NULL;
+	}
+	free((void *)ourzbuf);
+	ourzbuf = NULL;
+}
+
+
+static void
+dopicture(			/* interpolate and write current view */
+	int	ac,
+	char	*av[],
+	int	putview,
+	char	*zfile
+)
+{
+	int	i;
 							/* new header */
 	newheader("RADIANCE", stdout);
 	fputnow(stdout);
 							/* run pictures */
 	do {
 		memset((char *)ourzbuf, '\0', hresolu*vresolu*sizeof(float));
-		for (i = an; i < argc; i += 2)
-			addpicture(argv[i], argv[i+1]);
+		for (i = 0; i < nsrcpicts; i++)
+			addpicture(&srcpict[i]);
 		if (fillo&F_BACK)			/* fill in spaces */
 			backpicture(fillfunc, fillsamp);
 		else
@@ -318,12 +513,12 @@ main(			/* interpolate pictures */
 							/* aft clipping */
 		clipaft();
 	} while (addblur() && nextview(stdin) != EOF);
-							/* close calculation */
-	caldone();
+							/* finish calculation */
+	clearqueue();
 							/* add to header */
-	printargs(argc, argv, stdout);
+	printargs(ac, av, stdout);
 	compavgview();
-	if (doblur | gotvfile) {
+	if (putview) {
 		fputs(VIEWSTR, stdout);
 		fprintview(&avgview, stdout);
 		putc('\n', stdout);
@@ -344,14 +539,6 @@ main(			/* interpolate pictures */
 							/* write z file */
 	if (zfile != NULL)
 		writedistance(zfile);
-
-	exit(0);
-userr:
-	fprintf(stderr,
-	"Usage: %s [view opts][-t eps][-z zout][-e spec][-B][-a|-q][-fT][-n] pfile zspec ..\n",
-			progname);
-	exit(1);
-#undef check
 }
 
 
@@ -361,7 +548,9 @@ headline(				/* process header string */
 	void	*p
 )
 {
+	SRCPICT	*sp = (SRCPICT *)p;
 	char	fmt[MAXFMTLEN];
+	int	len;
 
 	if (isheadid(s))
 		return(0);
@@ -373,15 +562,18 @@ headline(				/* process header string */
 			wrongformat = 1;
 		return(0);
 	}
-	if (nvavg < 2) {
-		putc('\t', stdout);
-		fputs(s, stdout);
-	}
+	len = strlen(s);			/* save for output header */
+	sp->hdr = (char *)realloc((void *)sp->hdr, sp->hdrlen+len+2);
+	if (sp->hdr == NULL)
+		syserror(progname);
+	sp->hdr[sp->hdrlen++] = '\t';
+	strcpy(sp->hdr+sp->hdrlen, s);
+	sp->hdrlen += len;
 	if (isexpos(s)) {
-		theirexp *= exposval(s);
+		sp->expos *= exposval(s);
 		return(0);
 	}
-	if (isview(s) && sscanview(&theirview, s) > 0)
+	if (isview(s) && sscanview(&sp->vw, s) > 0)
 		gotview++;
 	return(0);
 }
@@ -456,7 +648,8 @@ compavgview(void)				/* compute average view */
 
 
 static void
-addpicture(		/* add picture to output */
+loadpicture(		/* load input picture and z-buffer */
+	SRCPICT	*sp,
 	char	*pfile,
 	char	*zspec
 )
@@ -464,95 +657,107 @@ addpicture(		/* add picture to output */
 	FILE	*pfp;
 	int	zfd;
 	char	*err;
-	COLR	*scanin;
-	float	*zin;
-	struct position	*plast;
-	struct bound	*xlim, ylim;
+	long	npix;
 	int	y;
 					/* open picture file */
 	if ((pfp = fopen(pfile, "r")) == NULL)
 		syserror(pfile);
 					/* get header with exposure and view */
-	theirexp = 1.0;
-	theirview = stdview;
+	sp->pfile = pfile;
+	sp->hdr = NULL;
+	sp->hdrlen = 0;
+	sp->expos = 1.0;
+	sp->vw = stdview;
 	gotview = 0;
-	if (nvavg < 2)
-		printf("%s:\n", pfile);
-	getheader(pfp, headline, NULL);
-	if (wrongformat || !gotview || !fgetsresolu(&tresolu, pfp)) {
+	getheader(pfp, headline, sp);
+	if (wrongformat || !gotview || !fgetsresolu(&sp->rs, pfp)) {
 		fprintf(stderr, "%s: picture format error\n", pfile);
 		exit(1);
 	}
-	if (ourexp <= 0)
-		ourexp = theirexp;
-	else if (ABS(theirexp-ourexp) > .01*ourexp)
-		fprintf(stderr, "%s: different exposure (warning)\n", pfile);
-	if ( (err = setview(&theirview)) ) {
+	if ( (err = setview(&sp->vw)) ) {
 		fprintf(stderr, "%s: %s\n", pfile, err);
 		exit(1);
 	}
-					/* compute transformation */
-	hasmatrix = pixform(theirs2ours, &theirview, &ourview);
-					/* get z specification or file */
-	zin = (float *)malloc(scanlen(&tresolu)*sizeof(float));
-	if (zin == NULL)
+					/* read picture */
+	npix = (long)scanlen(&sp->rs)*numscans(&sp->rs);
+	sp->pix = (COLR *)malloc(npix*sizeof(COLR));
+	if (sp->pix == NULL)
 		syserror(progname);
-	if ((zfd = open_float_depth(zspec, (long)tresolu.xr*tresolu.yr)) < 0) {
+	for (y = 0; y < numscans(&sp->rs); y++)
+		if (freadcolrs(sp->pix + (long)y*scanlen(&sp->rs),
+				scanlen(&sp->rs), pfp) < 0) {
+			fprintf(stderr, "%s: read error\n", pfile);
+			exit(1);
+		}
+	fclose(pfp);
+					/* get z specification or file */
+	if ((zfd = open_float_depth(zspec, npix)) < 0) {
 		double	zvalue;
 		int	x;
 		if (!isflt(zspec) || (zvalue = atof(zspec)) <= 0.0)
 			syserror(zspec);
-		for (x = scanlen(&tresolu); x-- > 0; )
-			zin[x] = zvalue;
+		sp->zbuf = (float *)malloc(scanlen(&sp->rs)*sizeof(float));
+		if (sp->zbuf == NULL)
+			syserror(progname);
+		for (x = scanlen(&sp->rs); x-- > 0; )
+			sp->zbuf[x] = zvalue;
+		sp->zstride = 0;
+		return;
 	}
+	sp->zbuf = (float *)malloc(npix*sizeof(float));
+	if (sp->zbuf == NULL)
+		syserror(progname);
+	if (readbuf(zfd, (char *)sp->zbuf, npix*sizeof(float)) <
+			npix*sizeof(float))
+		syserror(zspec);
+	sp->zstride = scanlen(&sp->rs);
+	close(zfd);
+}
+
+
+static void
+addpicture(		/* add picture to output */
+	SRCPICT	*sp
+)
+{
+	struct position	*plast;
+	struct bound	*xlim, ylim;
+	int	y;
+					/* set input view */
+	theirview = sp->vw;
+	tresolu = sp->rs;
+	theirexp = sp->expos;
+	if (nvavg < 2) {
+		printf("%s:\n", sp->pfile);
+		if (sp->hdrlen)
+			fputs(sp->hdr, stdout);
+	}
+	if (ourexp <= 0)
+		ourexp = theirexp;
+	else if (ABS(theirexp-ourexp) > .01*ourexp)
+		fprintf(stderr, "%s: different exposure (warning)\n",
+				sp->pfile);
+					/* compute transformation */
+	hasmatrix = pixform(theirs2ours, &theirview, &ourview);
 					/* compute transferrable perimeter */
 	xlim = (struct bound *)malloc(numscans(&tresolu)*sizeof(struct bound));
 	if (xlim == NULL)
 		syserror(progname);
-	if (!getperim(xlim, &ylim, zin, zfd)) {	/* overlapping area? */
-		free((void *)zin);
+	if (!getperim(xlim, &ylim, sp)) {	/* overlapping area? */
 		free((void *)xlim);
-		if (zfd != -1)
-			close(zfd);
-		fclose(pfp);
 		return;
 	}
-					/* allocate scanlines */
-	scanin = (COLR *)malloc(scanlen(&tresolu)*sizeof(COLR));
 	plast = (struct position *)calloc(scanlen(&tresolu),
 			sizeof(struct position));
-	if ((scanin == NULL) | (plast == NULL))
+	if (plast == NULL)
 		syserror(progname);
-					/* skip to starting point */
-	for (y = 0; y < ylim.min; y++)
-		if (freadcolrs(scanin, scanlen(&tresolu), pfp) < 0) {
-			fprintf(stderr, "%s: read error\n", pfile);
-			exit(1);
-		}
-	if (zfd != -1 && lseek(zfd,
-			(off_t)ylim.min*scanlen(&tresolu)*sizeof(float),
-			SEEK_SET) < 0)
-		syserror(zspec);
-					/* load image */
-	for (y = ylim.min; y <= ylim.max; y++) {
-		if (freadcolrs(scanin, scanlen(&tresolu), pfp) < 0) {
-			fprintf(stderr, "%s: read error\n", pfile);
-			exit(1);
-		}
-		if (zfd != -1 && read(zfd, (char *)zin,
-				scanlen(&tresolu)*sizeof(float))
-				< scanlen(&tresolu)*sizeof(float))
-			syserror(zspec);
-		addscanline(xlim+y, y, scanin, zin, plast);
-	}
+					/* warp image */
+	for (y = ylim.min; y <= ylim.max; y++)
+		addscanline(xlim+y, y, sp->pix + (long)y*scanlen(&tresolu),
+				sp->zbuf + (long)y*sp->zstride, plast);
 					/* clean up */
 	free((void *)xlim);
-	free((void *)scanin);
-	free((void *)zin);
 	free((void *)plast);
-	fclose(pfp);
-	if (zfd != -1)
-		close(zfd);
 }
 
 
@@ -783,10 +988,10 @@ static int
 getperim(		/* compute overlapping image area */
 	struct bound	*xl,
 	struct bound	*yl,
-	float	*zline,
-	int	zfd
+	SRCPICT	*sp
 )
 {
+	float	*zline;
 	int	step;
 	FVECT	pos;
 	int	x, y;
@@ -807,15 +1012,7 @@ getperim(		/* compute overlapping image area */
 	}
 	yl->min = 32000; yl->max = 0;		/* search for points on image */
 	for (y = step - 1; y < numscans(&tresolu); y += step) {
-		if (zfd != -1) {
-			if (lseek(zfd, (off_t)y*scanlen(&tresolu)*sizeof(float),
-					SEEK_SET) < 0)
-				syserror("lseek");
-			if (read(zfd, (char *)zline,
-					scanlen(&tresolu)*sizeof(float))
-					< scanlen(&tresolu)*sizeof(float))
-				syserror("read");
-		}
+		zline = sp->zbuf + (long)y*sp->zstride;
 		xl[y].min = 32000; xl[y].max = 0;		/* x max */
 		for (x = scanlen(&tresolu); (x -= step) > 0; ) {
 			pix2loc(pos, &tresolu, x, y);
@@ -112,10 +112,10 @@ ambsample(				/* initial ambient division sample */
 		multcolor(ar.rcoef, hp->acoef);
 		scalecolor(ar.rcoef, 1./AVGREFL);
 	}
-	hlist[0] = hp->rp->rno;
+	hlist[0] = (int)hp->rp->rkey;	/* same in any process */
 	hlist[1] = j;
 	hlist[2] = i;
-	multisamp(spt, 2, urand(ilhash(hlist,3)+n));
+	raymultisamp(spt, 2, rayurand(&ar, ilhash(hlist,3)+n), &ar);
 resample:
 	SDsquare2disk(spt, (j+spt[1])/hp->ns, (i+spt[0])/hp->ns);
 	zd = sqrt(1. - spt[0]*spt[0] - spt[1]*spt[1]);
@@ -126,7 +126,7 @@ resample:
 	checknorm(ar.rdir);
 					/* avoid coincident samples */
 	if (!n && ambcollision(hp, i, j, ar.rdir)) {
-		spt[0] = frandom(); spt[1] = frandom();
+		spt[0] = rayrand(&ar); spt[1] = rayrand(&ar);
 		goto resample;		/* reject this sample */
 	}
 	dimlist[ndims++] = AI(hp,i,j) + 90171;
@@ -243,7 +243,7 @@ ambsupersamp(AMBHEMI *hp, int cnt)
 	    for (j = 0; j < hp->ns; j++) {
 		if (e2rem <= FTINY)
 			goto done;	/* nothing left to do */
-		nss = *ep/e2rem*cnt + frandom();
+		nss = *ep/e2rem*cnt + rayrand(hp->rp);
 		for (n = 1; n <= nss && ambsample(hp,i,j,n); n++)
 			if (!--cnt) goto done;
 		e2rem -= *ep++;		/* update remainder */
@@ -291,7 +291,7 @@ samp_hemi(				/* sample indirect hemisphere */
 	d = 1.0/(n*n);
 	scalecolor(hp->acoef, d);
 					/* make tangent plane axes */
-	if (!getperpendicular(hp->ux, r->ron, 1))
+	if (!rayperpendicular(hp->ux, r->ron, r))
 		error(CONSISTENCY, "bad ray direction in samp_hemi");
 	VCROSS(hp->uy, r->ron, hp->ux);
 					/* sample divisions */
@@ -66,11 +66,15 @@ static unsigned int  navsum = 0;	/* number of values in avsum */
 static unsigned int  nambvals = 0;	/* total number of indirect values */
 #endif
 static unsigned int  nambshare = 0;	/* number of values from file */
+
+static size_t  ambmemvals = 0;		/* bytes allocated for values */
+static size_t  ambmemtree = 0;		/* bytes allocated for tree */
 static unsigned long  ambclock = 0;	/* ambient access clock */
 static unsigned long  lastsort = 0;	/* time of last value sort */
 static long  sortintvl = SORT_INTVL;	/* time until next sort */
 static FILE  *ambinp = NULL;		/* auxiliary file for input */
 static long  lastpos = -1;		/* last flush position */
+static int  rdepth = 0;			/* ambient recursion */
 
 #define MAXACLOCK	(1L<<30)	/* clock turnover value */
 	/*
@@ -86,8 +90,6 @@ static long  lastpos = -1;		/* last flush position */
 
 #define	 AMBFLUSH	(BUFSIZ/AMBVALSIZ)
 
-#define	 newambval()	(AMBVAL *)malloc(sizeof(AMBVAL))
-
 #define  tfunc(lwr, x, upr)	(((x)-(lwr))/((upr)-(lwr)))
 
 static void initambfile(int creat);
@@ -97,6 +99,7 @@ void avsave(AMBVAL *av);
 static void avsave(AMBVAL *av);
 #endif
 static AMBVAL *avstore(AMBVAL  *aval);
+static AMBVAL *newambval(void);
 static AMBTREE *newambtree(void);
 static void freeambtree(AMBTREE  *atp);
 
@@ -236,6 +239,11 @@ ambdone(void)			/* close ambient file and free memory */
 		}
 		lastpos = -1;
 	}
+#ifdef DEBUG
+	sprintf(errmsg, "ambient memory: %.1f MB values, %.1f MB tree\n",
+			ambmemvals*(1./(1024*1024)), ambmemtree*(1./(1024*1024)));
+	eputs(errmsg);
+#endif
 					/* free ambient tree */
 	unloadatree(&atrunk, avfree);
 					/* reset state variables */
@@ -289,7 +297,6 @@ multambient(		/* compute ambient component & multiply by coef. */
 #endif
 )
 {
-	static int  rdepth = 0;			/* ambient recursion */
 	COLOR	acol, caustic;
 	int	i, ok;
 	double	d, l;
@@ -359,6 +366,7 @@ multambient(		/* compute ambient component & multiply by coef. */
 	if (tracktime)				/* sort to minimize thrashing */
 		sortambvals(0);
 						/* interpolate ambient value */
+	RS_COUNT(amblookups);
 	setcolor(acol, 0.0, 0.0, 0.0);
 #ifndef DAYSIM
 	d = sumambient(acol, r, nrm, rdepth,
@@ -544,6 +552,7 @@ sumambient(		/* get interpolated ambient value */
 		if (av->lvl > al ||	/* list sorted, so this works */
 				(av->lvl == al) & (av->weight < 0.9*r->rweight))
 			break;
+		RS_COUNT(ambtests);
 		/*
 		 *  Direction test using unperturbed normal
 		 */
@@ -597,6 +606,7 @@ sumambient(		/* get interpolated ambient value */
 #ifdef DAYSIM
 		daysimAddScaled(daylightCoef, tempDaylightCoef, d);
 #endif
+		RS_COUNT(ambused);
 		wsum += d;
 	}
 	return(wsum);
@@ -660,6 +670,41 @@ makeambient(		/* make a new ambient value for storage */
 }
 
 
+#if defined(ACCELERAD) && !defined(DAYSIM)
+int
+ambrecord(		/* compute a first-level value without storing it */
+	AMBVAL  *av,
+	RAY  *r
+)
+{
+	COLOR	acol;
+	FVECT	uvw[3];
+	int	i;
+
+	if ((ambdiv <= 0) | (ambounce <= 0) | (ambacc <= FTINY))
+		return(0);
+	if (ambincl != -1 && r->ro != NULL &&
+			ambincl != inset(ambset, r->ro->omod))
+		return(0);
+	av->weight = 1.0;
+	setcolor(acol, AVGREFL, AVGREFL, AVGREFL);
+	rdepth++;				/* as if from multambient() */
+	i = doambient(acol, r, av->weight,
+			uvw, av->rad, av->gpos, av->gdir, &av->corral);
+	rdepth--;
+	if (i <= 0 || av->rad[0] <= FTINY)
+		return(0);
+	scalecolor(acol, 1./AVGREFL);		/* undo assumed reflectance */
+	VCOPY(av->pos, r->rop);
+	av->ndir = encodedir(r->ron);
+	av->udir = encodedir(uvw[0]);
+	av->lvl = 0;
+	copycolor(av->val, acol);
+	return(1);
+}
+#endif
+
+
 static int
 extambient(		/* extrapolate value at pv, nv */
 	COLOR  cr,
@@ -718,6 +763,7 @@ avinsert(				/* insert ambient value in our tree */
 
 	if (av->rad[0] <= FTINY)
 		error(CONSISTENCY, "zero ambient radius in avinsert");
+	RS_COUNT(ambinserts);
 	at = &atrunk;
 	VCOPY(ck0, thescene.cuorg);
 	s = thescene.cusize;
@@ -830,6 +876,33 @@ avstore(				/* allocate memory and save aval */
 }
 
 
+#define AVALLOCSZ	512		/* #values to allocate at once */
+
+static AMBVAL  *avfreelist = NULL;	/* free ambient value structures */
+
+
+static AMBVAL *
+newambval(void)				/* allocate an ambient value */
+{
+	AMBVAL  *av, *upperlim;
+
+	if (avfreelist == NULL) {	/* get more values */
+		avfreelist = (AMBVAL *)malloc(AVALLOCSZ*sizeof(AMBVAL));
+		if (avfreelist == NULL)
+			return(NULL);
+		ambmemvals += AVALLOCSZ*sizeof(AMBVAL);
+					/* link new free list */
+		upperlim = avfreelist + (AVALLOCSZ-1);
+		for (av = avfreelist; av < upperlim; av++)
+			av->next = av + 1;
+		av->next = NULL;
+	}
+	av = avfreelist;
+	avfreelist = av->next;
+	return(av);
+}
+
+
 #define ATALLOCSZ	512		/* #/8 trees to allocate at once */
 
 static AMBTREE  *atfreelist = NULL;	/* free ambient tree structures */
@@ -844,6 +917,7 @@ newambtree(void)				/* allocate 8 ambient tree structs */
 		atfreelist = (AMBTREE *)malloc(ATALLOCSZ*8*sizeof(AMBTREE));
 		if (atfreelist == NULL)
 			return(NULL);
+		ambmemtree += ATALLOCSZ*8*sizeof(AMBTREE);
 					/* link new free list */
 		upperlim = atfreelist + 8*(ATALLOCSZ-1);
 		for (atp = atfreelist; atp < upperlim; atp += 8)
@@ -900,9 +974,10 @@ static int	i_avlist;		/* index for lists */
 static int alatcmp(const void *av1, const void *av2);
 
 static void
-avfree(AMBVAL *av)
+avfree(AMBVAL *av)		/* return value to free list */
 {
-	free(av);
+	av->next = avfreelist;
+	avfreelist = av;
 }
 
 static void
@@ -62,6 +62,9 @@ extern void	multambient(COLOR aval, RAY *r, FVECT nrm);
 extern void	multambient(COLOR aval, RAY *r, FVECT nrm, DaysimCoef daylightCoef);
 #endif
 extern void	ambdone(void);
+#if defined(ACCELERAD) && !defined(DAYSIM)
+extern int	ambrecord(AMBVAL *av, RAY *r);
+#endif
 extern void	ambnotify(OBJECT obj);
 extern int	ambsync(void);
 					/* defined in ambcomp.c */
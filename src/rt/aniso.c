@@ -344,7 +344,7 @@ getacoords(		/* set up coordinate system */
 	if (normalize(np->v) == 0.0) {
 		if (fabs(np->u_alpha - np->v_alpha) > 0.001)
 			objerror(np->mp, WARNING, "illegal orientation vector");
-		getperpendicular(np->u, np->pnorm, 1);	/* punting */
+		rayperpendicular(np->u, np->pnorm, np->rp);	/* punting */
 		fcross(np->v, np->pnorm, np->u);
 		np->u_alpha = np->v_alpha = sqrt( 0.5 *
 			(np->u_alpha*np->u_alpha + np->v_alpha*np->v_alpha) );
@@ -386,10 +386,10 @@ agaussamp(		/* sample anisotropic Gaussian specular */
 		for (nstaken = ntrials = 0; nstaken < nstarget &&
 						ntrials < maxiter; ntrials++) {
 			if (ntrials)
-				d = frandom();
+				d = rayrand(np->rp);
 			else
-				d = urand(ilhash(dimlist,ndims)+samplendx);
-			multisamp(rv, 2, d);
+				d = rayurand(np->rp, ilhash(dimlist,ndims)+(int)np->rp->rkey);
+			raymultisamp(rv, 2, d, np->rp);
 			d = 2.0*PI * rv[0];
 			cosp = tcos(d) * np->u_alpha;
 			sinp = tsin(d) * np->v_alpha;
@@ -459,10 +459,10 @@ agaussamp(		/* sample anisotropic Gaussian specular */
 		for (nstaken = ntrials = 0; nstaken < nstarget &&
 						ntrials < maxiter; ntrials++) {
 			if (ntrials)
-				d = frandom();
+				d = rayrand(np->rp);
 			else
-				d = urand(ilhash(dimlist,ndims)+1823+samplendx);
-			multisamp(rv, 2, d);
+				d = rayurand(np->rp, ilhash(dimlist,ndims)+1823+(int)np->rp->rkey);
+			raymultisamp(rv, 2, d, np->rp);
 			d = 2.0*PI * rv[0];
 			cosp = tcos(d) * np->u_alpha;
 			sinp = tsin(d) * np->v_alpha;
@@ -226,7 +226,7 @@ getacoords_as(		/* set up coordinate system */
 	if (normalize(np->v) == 0.0) {
 		if (fabs(np->u_power - np->v_power) > 0.1)
 			objerror(np->mp, WARNING, "bad orientation vector");
-		getperpendicular(np->u, np->pnorm, 1);	/* punting */
+		rayperpendicular(np->u, np->pnorm, np->rp);	/* punting */
 		fcross(np->v, np->pnorm, np->u);
 		np->u_power = np->v_power =
 			2./(1./(np->u_power+1e-5) + 1./(np->v_power+1e-5));
@@ -267,10 +267,10 @@ ashiksamp(		/* sample anisotropic Ashikhmin-Shirley specular */
 	for (nstaken = ntrials = 0; nstaken < nstarget &&
 					ntrials < maxiter; ntrials++) {
 		if (ntrials)
-			dtmp = frandom();
+			dtmp = rayrand(np->rp);
 		else
-			dtmp = urand(ilhash(dimlist,ndims)+647+samplendx);
-		multisamp(rv, 2, dtmp);
+			dtmp = rayurand(np->rp, ilhash(dimlist,ndims)+647+(int)np->rp->rkey);
+		raymultisamp(rv, 2, dtmp, np->rp);
 		dtmp = 2.*PI * rv[0];
 		cosph = sqrt(np->v_power + 1.) * tcos(dtmp);
 		sinph = sqrt(np->u_power + 1.) * tsin(dtmp);
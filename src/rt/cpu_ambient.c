@@ -0,0 +1,380 @@
+/*
+ *  cpu_ambient.c - routines for seeding the irradiance cache on CPUs.
+ *
+ *  This follows the GPU pre-pass in optix_ambient.c.  First hits of a
+ *  grid of primary rays are grouped by k-means, one ambient value is
+ *  computed per cluster in parallel, and the values are added to the
+ *  cache before rendering starts.  Seeds are clustered locally, SLIC
+ *  style, so each one is only compared with the centers of nearby
+ *  tiles of the grid.  Tiles receive centers in proportion to their
+ *  geometric error, after Wang et al. (2009).
+ */
+
+#include "accelerad_copyright.h"
+
+#include "ray.h"
+#include "ambient.h"
+#include "otypes.h"
+#include "otspecial.h"
+
+#include "cpu_radiance.h"
+
+#if defined(ACCELERAD) && !defined(DAYSIM)
+
+#define MEANCLUSTERS	4	/* average centers per tile */
+
+#define vscale(v,f)	((v)[0]*=(f),(v)[1]*=(f),(v)[2]*=(f))
+
+typedef struct {
+	FVECT	pos;		/* first hit point */
+	FVECT	dir;		/* surface normal, zero if no seed */
+} SEEDPT;
+
+typedef struct {
+	FVECT	pos;		/* cluster center */
+	FVECT	dir;		/* mean normal */
+	int	tile;		/* tile that owns this center */
+	int	rep;		/* closest seed */
+	double	repdist;	/* its distance */
+} CLUSTER;
+
+extern unsigned int nambvals;		/* total number of indirect values */
+extern void avsave(AMBVAL *av);
+
+static int (*seed_ray)(RAY *r, const size_t i);	/* sets up ray i */
+static SEEDPT *seeds;		/* shared seed buffer */
+static int *seed_index;		/* seed chosen for each cluster */
+static AMBVAL *records;		/* shared record buffer */
+
+static void traceSeed(const size_t i);
+static void computeRecord(const size_t i);
+static int hitSeed(RAY *r, const size_t i);
+static double seedError(const FVECT pos1, const FVECT dir1, const FVECT pos2, const FVECT dir2, const double alpha);
+static int chooseClusters(const size_t width, const size_t height, const size_t count, int *chosen);
+
+
+/**
+ * Seed the irradiance cache for a batch laid out as width by height rays.
+ * The callback sets the origin, direction and length of ray i, returning
+ * zero if there is no such ray.  Nothing is done unless -ak+ is given,
+ * or if ambient values are not cached or the cache already holds values,
+ * e.g. from a file.
+ */
+void cpuAmbientSeed(const size_t width, const size_t height, int (*setray)(RAY *r, const size_t i), const int nprocs)
+{
+	const size_t size = width * height;
+	SEEDPT *seedbuf;
+	AMBVAL *recbuf;
+	size_t maxclusters, i;
+	int nclusters, nrecords;
+
+	if (!cpu_kmeans_seed || (ambacc <= FTINY) | (ambounce <= 0) | (ambdiv <= 0) || nambvals || cuda_kmeans_clusters <= 0 || !size)
+		return;
+	cpuSetup(nprocs);
+	seed_ray = setray;
+
+	/* Gather first hits */
+	seedbuf = (SEEDPT *)calloc(size, sizeof(SEEDPT));
+	if (seedbuf == NULL)
+		goto memerr;
+	seeds = (SEEDPT *)cpuShare(seedbuf, sizeof(SEEDPT) * size, nprocs);
+	cpuBatch(size, width > CPU_BLOCK ? width : CPU_BLOCK, &traceSeed, nprocs, NULL);
+	cpuUnshare(seedbuf, seeds, sizeof(SEEDPT) * size);
+	seeds = seedbuf;
+
+	/* Group them into clusters */
+	maxclusters = cuda_kmeans_clusters < size ? cuda_kmeans_clusters : size;
+	seed_index = (int *)malloc(maxclusters * sizeof(int));
+	if (seed_index == NULL)
+		goto memerr;
+	nclusters = chooseClusters(width, height, maxclusters, seed_index);
+
+	/* Compute one ambient value per cluster */
+	recbuf = (AMBVAL *)calloc(nclusters ? nclusters : 1, sizeof(AMBVAL));
+	if (recbuf == NULL)
+		goto memerr;
+	records = (AMBVAL *)cpuShare(recbuf, sizeof(AMBVAL) * nclusters, nprocs);
+	cpuBatch(nclusters, 1, &computeRecord, nprocs, NULL);
+	cpuUnshare(recbuf, records, sizeof(AMBVAL) * nclusters);
+
+	for (i = nrecords = 0; i < nclusters; i++)
+		if (recbuf[i].weight > 0.0f) {
+			avsave(&recbuf[i]);
+			nrecords++;
+		}
+	if (erract[WARNING].pf) {
+		sprintf(errmsg, "seeded %d ambient values from %d clusters\n", nrecords, nclusters);
+		(*erract[WARNING].pf)(errmsg);
+	}
+	free(recbuf);
+	free(seed_index);
+	free(seedbuf);
+	records = NULL;
+	seed_index = NULL;
+	seeds = NULL;
+	return;
+memerr:
+	error(SYSTEM, "out of memory in cpuAmbientSeed");
+}
+
+
+static void traceSeed(const size_t i)
+{
+	RAY r;
+
+	if (!hitSeed(&r, i))
+		return;
+	VCOPY(seeds[i].pos, r.rop);
+	VCOPY(seeds[i].dir, r.ron);
+}
+
+
+static void computeRecord(const size_t i)
+{
+	RAY r;
+
+	if (!hitSeed(&r, seed_index[i]))
+		return;
+	samplendx = (int)i + 1;	/* independent of scheduling */
+	if (!ambrecord(&records[i], &r))
+		records[i].weight = 0.0f;
+}
+
+
+/**
+ * Intersect ray i with the scene, returning nonzero if it lands on a
+ * surface that uses the ambient calculation.  The normal faces the ray.
+ */
+static int hitSeed(RAY *r, const size_t i)
+{
+	OBJREC *m;
+
+	if (!(*seed_ray)(r, i))
+		return 0;
+	rayorigin(r, PRIMARY, NULL, NULL);
+	r->rkey = raystream((RNUMBER)i + 1);	/* same in any process */
+	if (!localhit(r, &thescene) || r->ro == NULL || r->ro == &Aftplane)
+		return 0;
+	if ((m = findmaterial(r->ro)) == NULL || islight(m->otype))
+		return 0;
+	switch (m->otype) {
+	case MAT_MIRROR:
+	case MAT_GLASS:
+	case MAT_DIELECTRIC:
+	case MAT_INTERFACE:
+	case MAT_MIST:
+	case MAT_DIRECT1:
+	case MAT_DIRECT2:
+	case MAT_CLIP:
+		return 0;	/* no ambient on these */
+	}
+	if (r->rod < 0.0)
+		flipsurface(r);
+	return 1;
+}
+
+
+/**
+ * Irradiance cache error between two seeds, from Wang et al. Eq. 2.
+ * This matches ic_error() in cuda_kmeans.cu.
+ */
+static double seedError(const FVECT pos1, const FVECT dir1, const FVECT pos2, const FVECT dir2, const double alpha)
+{
+	const double d = 1.0 - DOT(dir1, dir2);
+
+	return alpha * sqrt(dist2(pos1, pos2)) + sqrt(d > 0.0 ? 2.0 * d : 0.0);
+}
+
+
+/**
+ * Pick up to count seeds as cluster representatives, returning how many.
+ */
+static int chooseClusters(const size_t width, const size_t height, const size_t count, int *chosen)
+{
+	const double alpha = cuda_kmeans_error / (ambacc * (maxarad > FTINY ? maxarad : 1.0));
+	size_t size = width * height;
+	size_t tsize, tw, th, ntiles, nvalid, i, x, y;
+	int *tfirst, *membership, nclusters, t, j, k, loops, changed;
+	double *terr, etotal, *frac;
+	CLUSTER *cl;
+	SEEDPT mean;
+
+	for (i = nvalid = 0; i < size; i++)
+		if (DOT(seeds[i].dir, seeds[i].dir) > FTINY)
+			nvalid++;
+	if (nvalid <= count) {		/* use them all */
+		for (i = nclusters = 0; i < size; i++)
+			if (DOT(seeds[i].dir, seeds[i].dir) > FTINY)
+				chosen[nclusters++] = (int)i;
+		return nclusters;
+	}
+
+	/* Lay tiles over the grid */
+	tsize = (size_t)(sqrt((double)size * MEANCLUSTERS / count) + .5);
+	if (tsize < 1)
+		tsize = 1;
+	tw = (width + tsize - 1) / tsize;
+	th = (height + tsize - 1) / tsize;
+	ntiles = tw * th;
+	tfirst = (int *)calloc(ntiles + 1, sizeof(int));
+	terr = (double *)calloc(ntiles, sizeof(double));
+	frac = (double *)calloc(ntiles, sizeof(double));
+	membership = (int *)malloc(size * sizeof(int));
+	cl = (CLUSTER *)malloc(count * sizeof(CLUSTER));
+	if (tfirst == NULL || terr == NULL || frac == NULL || membership == NULL || cl == NULL)
+		error(SYSTEM, "out of memory in chooseClusters");
+
+#define seedtile(i)	((int)(((i) / width / tsize) * tw + (i) % width / tsize))
+#define isseed(i)	(DOT(seeds[i].dir, seeds[i].dir) > FTINY)
+
+	/* Score tiles by geometric error about their mean */
+	for (t = 0; t < ntiles; t++) {
+		const size_t x0 = t % tw * tsize, y0 = t / tw * tsize;
+		int n = 0;
+
+		memset(&mean, 0, sizeof(SEEDPT));
+		for (y = y0; y < y0 + tsize && y < height; y++)
+			for (x = x0; x < x0 + tsize && x < width; x++) {
+				i = y * width + x;
+				if (isseed(i)) {
+					VADD(mean.pos, mean.pos, seeds[i].pos);
+					VADD(mean.dir, mean.dir, seeds[i].dir);
+					n++;
+				}
+			}
+		if (!n)
+			continue;
+		vscale(mean.pos, 1.0 / n);
+		normalize(mean.dir);
+		for (y = y0; y < y0 + tsize && y < height; y++)
+			for (x = x0; x < x0 + tsize && x < width; x++) {
+				i = y * width + x;
+				if (isseed(i))
+					terr[t] += seedError(seeds[i].pos, seeds[i].dir, mean.pos, mean.dir, alpha) + FTINY;
+			}
+		tfirst[t] = n;		/* temporarily hold seed count */
+	}
+
+	/* Share out centers in proportion to error (largest remainder) */
+	for (t = 0, etotal = 0.0; t < ntiles; t++)
+		etotal += terr[t];
+	for (t = 0, nclusters = 0; t < ntiles; t++) {
+		const double share = count * terr[t] / etotal;
+		k = (int)share;
+		if (k > tfirst[t])
+			k = tfirst[t];
+		frac[t] = k < tfirst[t] ? share - k : -1.0;
+		terr[t] = k;		/* now holds allocation */
+		nclusters += k;
+	}
+	while (nclusters < count) {
+		for (t = 0, j = -1; t < ntiles; t++)
+			if (frac[t] >= 0.0 && (j < 0 || frac[t] > frac[j]))
+				j = t;
+		if (j < 0)
+			break;
+		terr[j] += 1.0;
+		nclusters++;
+		frac[j] = terr[j] < tfirst[j] ? -.5 : -1.0;
+	}
+
+	/* Place initial centers at evenly spaced seeds in each tile */
+	for (t = 0, nclusters = 0; t < ntiles; t++) {
+		const size_t x0 = t % tw * tsize, y0 = t / tw * tsize;
+		const int n = tfirst[t], m = (int)terr[t];
+		int rank = 0;
+
+		tfirst[t] = nclusters;
+		if (!m)
+			continue;
+		k = 0;
+		for (y = y0; y < y0 + tsize && y < height; y++)
+			for (x = x0; x < x0 + tsize && x < width; x++) {
+				i = y * width + x;
+				if (!isseed(i))
+					continue;
+				if (k < m && rank == (int)((k + .5) * n / m)) {
+					VCOPY(cl[nclusters].pos, seeds[i].pos);
+					VCOPY(cl[nclusters].dir, seeds[i].dir);
+					cl[nclusters++].tile = t;
+					k++;
+				}
+				rank++;
+			}
+	}
+	tfirst[ntiles] = nclusters;
+
+	/* Lloyd iterations, searching the 3x3 neighboring tiles */
+	for (loops = 0; ; loops++) {
+		changed = 0;
+		for (j = 0; j < nclusters; j++)
+			cl[j].repdist = FHUGE;
+		for (i = 0; i < size; i++) {
+			const int t0 = isseed(i) ? seedtile(i) : -1;
+			double dmin = FHUGE, d;
+			int best = -1, tx, ty;
+
+			if (t0 < 0) {
+				membership[i] = -1;
+				continue;
+			}
+			for (ty = t0 / (int)tw - 1; ty <= t0 / (int)tw + 1; ty++) {
+				if ((ty < 0) | (ty >= (int)th))
+					continue;
+				for (tx = t0 % (int)tw - 1; tx <= t0 % (int)tw + 1; tx++) {
+					if ((tx < 0) | (tx >= (int)tw))
+						continue;
+					t = ty * (int)tw + tx;
+					for (j = tfirst[t]; j < tfirst[t + 1]; j++) {
+						d = seedError(seeds[i].pos, seeds[i].dir, cl[j].pos, cl[j].dir, alpha);
+						if (d < dmin) {
+							dmin = d;
+							best = j;
+						}
+					}
+				}
+			}
+			if (loops && best != membership[i])
+				changed++;
+			membership[i] = best;
+			if (best >= 0 && dmin < cl[best].repdist) {
+				cl[best].repdist = dmin;
+				cl[best].rep = (int)i;
+			}
+		}
+		if (loops >= cuda_kmeans_iterations || (loops && changed <= cuda_kmeans_threshold * nvalid))
+			break;
+		for (j = 0; j < nclusters; j++) {	/* move centers to means */
+			memset(cl[j].pos, 0, sizeof(FVECT));
+			memset(cl[j].dir, 0, sizeof(FVECT));
+			cl[j].repdist = 0.0;	/* member count */
+		}
+		for (i = 0; i < size; i++)
+			if ((j = membership[i]) >= 0) {
+				VADD(cl[j].pos, cl[j].pos, seeds[i].pos);
+				VADD(cl[j].dir, cl[j].dir, seeds[i].dir);
+				cl[j].repdist += 1.0;
+			}
+		for (j = 0; j < nclusters; j++)
+			if (cl[j].repdist > 0.0) {
+				vscale(cl[j].pos, 1.0 / cl[j].repdist);
+				normalize(cl[j].dir);
+			}
+	}
+#undef seedtile
+#undef isseed
+
+	/* Keep the seed closest to each nonempty cluster */
+	for (j = k = 0; j < nclusters; j++)
+		if (cl[j].repdist < FHUGE)
+			chosen[k++] = cl[j].rep;
+
+	free(cl);
+	free(membership);
+	free(frac);
+	free(terr);
+	free(tfirst);
+	return k;
+}
+
+#endif /* ACCELERAD && !DAYSIM */
@@ -0,0 +1,158 @@
+/*
+ *  cpu_radiance.c - common routines for the GPU entry points on CPUs.
+ *
+ *  Builds without OptiX link these in place of the optix_*.c wrappers,
+ *  so the batched code paths run the standard Radiance ray evaluation.
+ *  Batches are cut into blocks that are spread over forked processes
+ *  writing into shared memory, which keeps results in input order.
+ */
+
+#include "accelerad_copyright.h"
+
+#include <time.h>
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "ray.h"
+
+#include "cpu_radiance.h"
+
+#ifdef ACCELERAD
+
+static int cpu_ready = 0;	/* deferred setup done? */
+
+
+/**
+ * Preload object data once, before the first batch.  The drivers mark
+ * sources as usual, so ray numbers follow the same order as without -g.
+ */
+void cpuSetup(const int nprocs)
+{
+	if (cpu_ready)
+		return;
+	if (nprocs > 1)
+		preload_objs();	/* so workers share it */
+	cpu_ready = 1;
+}
+
+
+/**
+ * Return a copy of the buffer in anonymous shared memory if forked
+ * workers will be writing to it, or the buffer itself otherwise.
+ */
+void *cpuShare(void *buf, const size_t size, const int nprocs)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	return buf;
+#else
+	void *shared;
+
+	if (nprocs <= 1 || !size)
+		return buf;
+	shared = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_ANON|MAP_SHARED, -1, 0);
+	if (shared == MAP_FAILED)
+		error(SYSTEM, "cannot map shared batch buffer");
+	memcpy(shared, buf, size);
+	return shared;
+#endif
+}
+
+
+/**
+ * Copy the results from a buffer returned by cpuShare() and release it.
+ */
+void cpuUnshare(void *buf, void *shared, const size_t size)
+{
+	if (shared == buf)
+		return;
+#if !defined(_WIN32) && !defined(_WIN64)
+	memcpy(buf, shared, size);
+	munmap(shared, size);
+#endif
+}
+
+
+/**
+ * Evaluate items 0 to n-1 in blocks of the given size.  Blocks are dealt
+ * round-robin to nprocs processes; the caller takes the first share and
+ * reports progress as it goes.
+ */
+void cpuBatch(const size_t n, const size_t block, void (*work)(const size_t), const int nprocs, void (*freport)(double))
+{
+	const size_t nblocks = (n + block - 1) / block;
+	size_t b, i, end;
+	int np = nprocs, k = 0;
+#if !defined(_WIN32) && !defined(_WIN64)
+	pid_t *pids = NULL;
+	int status;
+#endif
+
+	if (!n)
+		return;
+	if (np > nblocks)
+		np = (int)nblocks;
+#if defined(_WIN32) || defined(_WIN64)
+	np = 1;
+#else
+	if (np > 1) {
+		pids = (pid_t *)malloc(np * sizeof(pid_t));
+		if (pids == NULL)
+			error(SYSTEM, "out of memory in cpuBatch");
+		fflush(stdout);
+		for (k = 1; k < np; k++) {
+			if ((pids[k] = fork()) < 0)
+				error(SYSTEM, "cannot fork worker process");
+			if (!pids[k]) {
+				RS_INIT();	/* count worker k apart */
+				break;
+			}
+		}
+		if (k == np)
+			k = 0;
+	}
+#endif
+	for (b = k; b < nblocks; b += np) {
+		end = (b + 1) * block;
+		if (end > n)
+			end = n;
+		for (i = b * block; i < end; i++)
+			(*work)(i);
+		if (!k && freport)
+			(*freport)(100. * (b + 1) / nblocks);
+	}
+#if !defined(_WIN32) && !defined(_WIN64)
+	if (k) {
+		RS_REPORT();	/* worker statistics, if enabled */
+		_exit(0);	/* worker done, skip atexit and stdio */
+	}
+	for (k = 1; k < np; k++) {
+		if (waitpid(pids[k], &status, 0) < 0)
+			error(SYSTEM, "wait failed in cpuBatch");
+		if (status)
+			error(USER, "worker process died");
+	}
+	if (pids)
+		free(pids);
+#endif
+}
+
+
+void endOptix()
+{
+	/* Nothing is cached between frames on the CPU */
+}
+
+
+void printRayTracingTime(const clock_t clock)
+{
+	/* Print the given elapsed time for ray tracing */
+	if (erract[WARNING].pf) {
+		sprintf(errmsg, "Ray tracing total: %.3f seconds.\n", (double)clock / CLOCKS_PER_SEC);
+		(*erract[WARNING].pf)(errmsg);
+	}
+}
+
+#endif /* ACCELERAD */
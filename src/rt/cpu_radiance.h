@@ -0,0 +1,39 @@
+/*
+ *  cpu_radiance.h - declarations for the CPU fallback of the GPU entry points.
+ */
+
+#ifndef CPU_RADIANCE_H
+#define CPU_RADIANCE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of batch items per work block */
+#define CPU_BLOCK	64
+
+/* Preload scene data once before the first batch */
+extern void cpuSetup(const int nprocs);
+
+/* Place a batch buffer where forked workers can write to it */
+extern void *cpuShare(void *buf, const size_t size, const int nprocs);
+
+/* Copy results back from a shared buffer and release it */
+extern void cpuUnshare(void *buf, void *shared, const size_t size);
+
+/* Run work() on items 0 to n-1 in blocks spread over nprocs processes */
+extern void cpuBatch(const size_t n, const size_t block, void (*work)(const size_t), const int nprocs, void (*freport)(double));
+
+/* Seed the irradiance cache from first hits of a width by height batch */
+#ifndef DAYSIM
+extern void cpuAmbientSeed(const size_t width, const size_t height, int (*setray)(struct ray *r, const size_t i), const int nprocs);
+#else
+#define cpuAmbientSeed(width, height, setray, nprocs)	/* not supported */
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CPU_RADIANCE_H */
@@ -0,0 +1,55 @@
+/*
+ *  cpu_rcontrib.c - routines for generating contribution coefficients on CPUs.
+ */
+
+#include "accelerad_copyright.h"
+
+#include "ray.h"
+#include "source.h"
+#include "lookup.h"
+#include "rcontrib.h"
+
+#include "cpu_radiance.h"
+
+#ifdef ACCELERAD
+
+extern void done_contrib();
+extern void eval_irrad(FVECT org, FVECT dir);
+extern void eval_rad(FVECT org, FVECT dir, double dmax);
+
+
+/**
+ * Evaluate a batch of rays in input order, accumulating contributions
+ * through the rcontrib trace callback.  Records are written as they fill.
+ * Contributions are summed into shared bins, so this runs in one process.
+ */
+void contribOptix(const size_t width, const size_t height, const size_t ray_count, const unsigned int imm_irrad, const unsigned int lim_dist, const unsigned int contrib, const unsigned int bins, double* rays, LUTAB* modifiers)
+{
+	FVECT org, dir;
+	double d;
+	size_t i;
+	int sn;
+
+	cpuSetup(1);
+	for (sn = 0; sn < nsources; sn++)	/* tracing to sources as well */
+		source[sn].sflags |= SFOLLOW;
+
+	for (i = 0u; i < ray_count; i++, rays += 6) {
+		VCOPY(org, rays);
+		VCOPY(dir, rays + 3);
+		if ((d = normalize(dir)) == 0.0)
+			;			/* dummy ray */
+		else if (imm_irrad)
+			eval_irrad(org, dir);
+		else
+			eval_rad(org, dir, lim_dist ? d : 0.0);
+
+		/* accumulate/output values for this ray */
+		done_contrib();
+	}
+	/* pad the final record as on the GPU */
+	for (i = ray_count; i < width * height; i++)
+		done_contrib();
+}
+
+#endif /* ACCELERAD */
@@ -0,0 +1,77 @@
+/*
+ *  cpu_rpict.c - routines for picture generation on CPUs.
+ */
+
+#include "accelerad_copyright.h"
+
+#include "ray.h"
+#include "view.h"
+
+#include "cpu_radiance.h"
+
+#ifdef ACCELERAD
+
+extern int nproc;
+extern double pixvalue(COLOR col, int x, int y);
+
+static const VIEW *seed_view;	/* view for ambient seeding */
+static size_t seed_width, seed_height;
+static size_t xres, yres;	/* size of current frame */
+static COLOR *frame_colors;	/* shared output buffers */
+static float *frame_depths;
+
+static int seedRay(RAY *r, const size_t i);
+static void renderPixel(const size_t i);
+
+
+/**
+ * Render a frame pixel by pixel with the rpict sampling of the given view,
+ * which must be the current view.  Pixels are stored from the bottom row up.
+ * Every pixel is traced, so rpict only comes here with -ps 1.
+ */
+void renderOptix(const VIEW* view, const size_t width, const size_t height, const double dstrpix, const double mblur, const double dblur, COLOR* colors, float* depths, void (*freport)(double))
+{
+	const size_t size = width * height;
+
+	cpuSetup(nproc);
+
+	/* Seed the irradiance cache, optionally at reduced resolution (-al) */
+	seed_view = view;
+	seed_width = optix_amb_scale > 0 ? width / optix_amb_scale : width;
+	seed_height = optix_amb_scale > 0 ? height / optix_amb_scale : height;
+	if (!seed_width)
+		seed_width = 1;
+	if (!seed_height)
+		seed_height = 1;
+	cpuAmbientSeed(seed_width, seed_height, &seedRay, nproc);
+
+	xres = width;
+	yres = height;
+	frame_colors = (COLOR *)cpuShare(colors, sizeof(COLOR) * size, nproc);
+	frame_depths = (float *)cpuShare(depths, sizeof(float) * size, nproc);
+	cpuBatch(size, width, &renderPixel, nproc, freport);
+	cpuUnshare(colors, frame_colors, sizeof(COLOR) * size);
+	cpuUnshare(depths, frame_depths, sizeof(float) * size);
+	frame_colors = NULL;
+	frame_depths = NULL;
+}
+
+
+static int seedRay(RAY *r, const size_t i)
+{
+	const double hpos = (i % seed_width + .5) / seed_width;
+	const double vpos = (i / seed_width + .5) / seed_height;
+
+	return (r->rmax = viewray(r->rorg, r->rdir, (VIEW *)seed_view, hpos, vpos)) >= -FTINY;
+}
+
+
+static void renderPixel(const size_t j)
+{
+	const size_t y = yres - 1 - j / xres;	/* top row first, as rpict */
+	const size_t i = y * xres + j % xres;
+
+	frame_depths[i] = (float)pixvalue(frame_colors[i], (int)(i % xres), (int)y);
+}
+
+#endif /* ACCELERAD */
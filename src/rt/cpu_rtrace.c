@@ -0,0 +1,65 @@
+/*
+ *  cpu_rtrace.c - routines for individual ray tracing on CPUs.
+ */
+
+#include "accelerad_copyright.h"
+
+#include "ray.h"
+
+#include "cpu_radiance.h"
+
+#ifdef ACCELERAD
+
+extern int nproc;
+
+static RAY *batch;	/* rays being evaluated */
+
+static int seedRay(RAY *r, const size_t i);
+static void traceRay(const size_t i);
+
+
+/**
+ * Evaluate a batch of rays set up by rtrace, in place.
+ * Rays with a null direction stand for flush requests and are left empty.
+ */
+void computeOptix(const size_t width, const size_t height, const unsigned int imm_irrad, RAY* rays)
+{
+	const size_t size = width * height;
+
+	cpuSetup(nproc);
+	batch = rays;
+	cpuAmbientSeed(width, height, &seedRay, nproc);
+	batch = (RAY *)cpuShare(rays, sizeof(RAY) * size, nproc);
+	cpuBatch(size, width > CPU_BLOCK ? width : CPU_BLOCK, &traceRay, nproc, NULL);
+	cpuUnshare(rays, batch, sizeof(RAY) * size);
+	batch = NULL;
+}
+
+
+static int seedRay(RAY *r, const size_t i)
+{
+	const RAY *br = batch + i;
+
+	if (br->revf != raytrace || DOT(br->rdir, br->rdir) <= FTINY)
+		return 0;	/* no first hit to seed from */
+	VCOPY(r->rorg, br->rorg);
+	VCOPY(r->rdir, br->rdir);
+	r->rmax = br->rmax;
+	return 1;
+}
+
+
+static void traceRay(const size_t i)
+{
+	RAY *r = batch + i;
+
+	if (DOT(r->rdir, r->rdir) <= FTINY)
+		return;
+	samplendx = (int)r->rno;	/* input index from rtrace */
+	raynum = r->rno << 16;		/* keep ray trees apart */
+	if (sizeof(RNUMBER) > 4)
+		raynum <<= 16;
+	rayvalue(r);
+}
+
+#endif /* ACCELERAD */
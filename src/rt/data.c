@@ -32,10 +32,16 @@ static const char	RCSid[] = "$Id: data.c,v 2.33 2018/08/02 18:33:48 greg Exp $";
 
 #define hash(s)		(shash(s)%TABSIZ)
 
+				/* array element n as a value */
+#define datelem(dp,n)	((dp)->type == DATATY ? (double)(dp)->arr.d[n] : \
+				colrval((dp)->arr.c[n],(dp)->type))
+
 
 static DATARRAY	 *dtab[TABSIZ];		/* data array list */
 
 static gethfunc headaspect;
+static int datindex(DATARRAY *dp, int k, double v, double *xp);
+static double datblend(double y0, double y1, int i, double x);
 
 
 DATARRAY *
@@ -295,81 +301,58 @@ freedata(			/* release data array reference */
 }
 
 
-double
-datavalue(		/* interpolate data value at a point */
+static int
+datindex(		/* locate lower index in dimension k */
 	DATARRAY  *dp,
-	double	*pt
+	int  k,
+	double	v,
+	double	*xp
 )
 {
-	DATARRAY  sd;
-	int  asize;
 	int  lower, upper;
 	int  i;
-	double	x, y0, y1;
-					/* set up dimensions for recursion */
-	if (dp->nd > 1) {
-		sd.name = dp->name;
-		sd.type = dp->type;
-		sd.nd = dp->nd - 1;
-		asize = 1;
-		for (i = 0; i < sd.nd; i++) {
-			sd.dim[i].org = dp->dim[i+1].org;
-			sd.dim[i].siz = dp->dim[i+1].siz;
-			sd.dim[i].p = dp->dim[i+1].p;
-			asize *= sd.dim[i].ne = dp->dim[i+1].ne;
-		}
-	}
-					/* get independent variable */
-	if (dp->dim[0].p == NULL) {		/* evenly spaced points */
-		x = (pt[0] - dp->dim[0].org)/dp->dim[0].siz;
-		x *= (double)(dp->dim[0].ne - 1);
-		i = x;
+
+	if (dp->dim[k].p == NULL) {		/* evenly spaced points */
+		*xp = (v - dp->dim[k].org)/dp->dim[k].siz;
+		*xp *= (double)(dp->dim[k].ne - 1);
+		i = *xp;
 		if (i < 0)
 			i = 0;
-		else if (i > dp->dim[0].ne - 2)
-			i = dp->dim[0].ne - 2;
-	} else {				/* unevenly spaced points */
-		if (dp->dim[0].siz > 0.0) {
-			lower = 0;
-			upper = dp->dim[0].ne;
-		} else {
-			lower = dp->dim[0].ne;
-			upper = 0;
-		}
-		do {
-			i = (lower + upper) >> 1;
-			if (pt[0] >= dp->dim[0].p[i])
-				lower = i;
-			else
-				upper = i;
-		} while (i != (lower + upper) >> 1);
-		if (i > dp->dim[0].ne - 2)
-			i = dp->dim[0].ne - 2;
-		x = i + (pt[0] - dp->dim[0].p[i]) /
-				(dp->dim[0].p[i+1] - dp->dim[0].p[i]);
+		else if (i > dp->dim[k].ne - 2)
+			i = dp->dim[k].ne - 2;
+		return(i);
 	}
-					/* get dependent variable */
-	if (dp->nd > 1) {
-		if (dp->type == DATATY) {
-			sd.arr.d = dp->arr.d + i*asize;
-			y0 = datavalue(&sd, pt+1);
-			sd.arr.d = dp->arr.d + (i+1)*asize;
-			y1 = datavalue(&sd, pt+1);
-		} else {
-			sd.arr.c = dp->arr.c + i*asize;
-			y0 = datavalue(&sd, pt+1);
-			sd.arr.c = dp->arr.c + (i+1)*asize;
-			y1 = datavalue(&sd, pt+1);
-		}
+						/* unevenly spaced points */
+	if (dp->dim[k].siz > 0.0) {
+		lower = 0;
+		upper = dp->dim[k].ne;
 	} else {
-		if (dp->type == DATATY) {
-			y0 = dp->arr.d[i];
-			y1 = dp->arr.d[i+1];
-		} else {
-			y0 = colrval(dp->arr.c[i],dp->type);
-			y1 = colrval(dp->arr.c[i+1],dp->type);
-		}
+		lower = dp->dim[k].ne;
+		upper = 0;
 	}
+	do {
+		i = (lower + upper) >> 1;
+		if (v >= dp->dim[k].p[i])
+			lower = i;
+		else
+			upper = i;
+	} while (i != (lower + upper) >> 1);
+	if (i > dp->dim[k].ne - 2)
+		i = dp->dim[k].ne - 2;
+	*xp = i + (v - dp->dim[k].p[i]) /
+			(dp->dim[k].p[i+1] - dp->dim[k].p[i]);
+	return(i);
+}
+
+
+static double
+datblend(		/* interpolate between neighbors */
+	double	y0,
+	double	y1,
+	int  i,
+	double	x
+)
+{
 	/*
 	 * Extrapolate as far as one division, then
 	 * taper off harmonically to zero.
@@ -382,3 +365,51 @@ datavalue(		/* interpolate data value at a point */
 
 	return( y0*((i+1)-x) + y1*(x-i) );
 }
+
+
+double
+datavalue(		/* interpolate data value at a point */
+	DATARRAY  *dp,
+	double	*pt
+)
+{
+	double	x[MAXDDIM], y[1<<MAXDDIM];
+	int  ilo[MAXDDIM], stride[MAXDDIM];
+	int  base, ne1, n;
+	int  i, k;
+					/* locate cell in each dimension */
+	for (k = 0; k < dp->nd; k++)
+		ilo[k] = datindex(dp, k, pt[k], &x[k]);
+	if (dp->nd == 2) {		/* common case for pictures */
+		ne1 = dp->dim[1].ne;
+		base = ilo[0]*ne1 + ilo[1];
+		return( datblend(
+			datblend(datelem(dp,base), datelem(dp,base+1),
+					ilo[1], x[1]),
+			datblend(datelem(dp,base+ne1), datelem(dp,base+ne1+1),
+					ilo[1], x[1]),
+			ilo[0], x[0]) );
+	}
+					/* gather cell corners */
+	stride[dp->nd-1] = 1;
+	for (k = dp->nd-1; k > 0; k--)
+		stride[k-1] = stride[k]*dp->dim[k].ne;
+	base = 0;
+	for (k = 0; k < dp->nd; k++)
+		base += ilo[k]*stride[k];
+	n = 1 << dp->nd;
+	for (i = 0; i < n; i++) {	/* last dimension in lowest bit */
+		int  ndx = base;
+		for (k = 0; k < dp->nd; k++)
+			if (i & 1<<(dp->nd-1-k))
+				ndx += stride[k];
+		y[i] = datelem(dp,ndx);
+	}
+					/* reduce from last dimension up */
+	for (k = dp->nd; k--; ) {
+		n >>= 1;
+		for (i = 0; i < n; i++)
+			y[i] = datblend(y[2*i], y[2*i+1], ilo[k], x[k]);
+	}
+	return(y[0]);
+}
@@ -233,6 +233,7 @@ setfunc(			/* set channels for function call */
 					/* get function if any */
 	if ((f = (MFUNC *)m->os) == NULL)
 		objerror(m, CONSISTENCY, "setfunc called before getfunc");
+	RS_COUNT(funcevals);
 		
 	setcontext(f->ctx);		/* set evaluator context */
 					/* check to see if matrix set */
@@ -91,6 +91,7 @@ initotypes(void)			/* initialize ofun array */
 	ofun[MIX_FUNC].funp = mx_func;
 	ofun[MIX_DATA].funp = mx_data;
 	ofun[MIX_PICT].funp = mx_pdata;
+	RS_INIT();			/* start statistics if enabled */
 }
 
 
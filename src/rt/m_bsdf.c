@@ -116,7 +116,7 @@ compute_through(BSDFDAT *ndp)
 					{0, -1.6},
 					{1.6, 0},
 				};
-	const double	peak_over = 1.3 + .4*frandom();	/* jitter threshold */
+	const double	peak_over = 1.3 + .4*rayrand(ndp->pr);	/* jitter threshold */
 	SDSpectralDF	*dfp;
 	FVECT		pdir;
 	double		tomega, srchrad;
@@ -145,6 +145,7 @@ compute_through(BSDFDAT *ndp)
 		tdir[1] = -ndp->vray[1] + dir2check[i][1]*srchrad;
 		tdir[2] = -ndp->vray[2];
 		normalize(tdir);
+		RS_COUNT(bsdfq);
 		ec = SDevalBSDF(&sv, tdir, ndp->vray, ndp->sd);
 		if (ec)
 			goto baderror;
@@ -186,8 +187,8 @@ bsdf_jitter(FVECT vres, BSDFDAT *ndp, double sr_psa)
 		sr_psa *= specjitter;
 	if (sr_psa <= FTINY)
 		return;
-	vres[0] += sr_psa*(.5 - frandom());
-	vres[1] += sr_psa*(.5 - frandom());
+	vres[0] += sr_psa*(.5 - rayrand(ndp->pr));
+	vres[1] += sr_psa*(.5 - rayrand(ndp->pr));
 	normalize(vres);
 }
 
@@ -266,13 +267,14 @@ direct_specular_OK(COLOR cval, FVECT ldir, double omega, BSDFDAT *ndp)
 	for (i = nsamp; i--; ) {
 		VCOPY(vsmp, vsrc);	/* jitter query directions */
 		if (nsamp > 1) {
-			multisamp(sd, 2, (i + frandom())/(double)nsamp);
+			raymultisamp(sd, 2, (i + rayrand(ndp->pr))/(double)nsamp, ndp->pr);
 			vsmp[0] += (sd[0] - .5)*sf;
 			vsmp[1] += (sd[1] - .5)*sf;
 			normalize(vsmp);
 		}
 		bsdf_jitter(vjit, ndp, tsr);
 					/* compute BSDF */
+		RS_COUNT(bsdfq);
 		ec = SDevalBSDF(&sv, vjit, vsmp, ndp->sd);
 		if (ec)
 			goto baderror;
@@ -471,15 +473,16 @@ sample_sdcomp(BSDFDAT *ndp, SDComponent *dcp, int xmit)
 						/* run through our samples */
 	for (n = 0; n < nstarget; n++) {
 		if (nstarget == 1) {		/* stratify random variable */
-			xrand = urand(ilhash(dimlist,ndims)+samplendx);
+			xrand = rayurand(ndp->pr, ilhash(dimlist,ndims)+(int)ndp->pr->rkey);
 			if (specjitter < 1.)
 				xrand = .5 + specjitter*(xrand-.5);
 		} else {
-			xrand = (n + frandom())/(double)nstarget;
+			xrand = (n + rayrand(ndp->pr))/(double)nstarget;
 		}
 		SDerrorDetail[0] = '\0';	/* sample direction & coef. */
 		bsdf_jitter(vsmp, ndp, ndp->sr_vpsa[0]);
 		VCOPY(vinc, vsmp);		/* to compare after */
+		RS_COUNT(bsdfq);
 		ec = SDsampComponent(&bsv, vsmp, xrand, dcp);
 		if (ec)
 			objerror(ndp->mp, USER, transSDError(ec));
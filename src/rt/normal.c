@@ -452,10 +452,10 @@ gaussamp(			/* sample Gaussian specular */
 		for (nstaken = ntrials = 0; nstaken < nstarget &&
 						ntrials < maxiter; ntrials++) {
 			if (ntrials)
-				d = frandom();
+				d = rayrand(np->rp);
 			else
-				d = urand(ilhash(dimlist,ndims)+samplendx);
-			multisamp(rv, 2, d);
+				d = rayurand(np->rp, ilhash(dimlist,ndims)+(int)np->rp->rkey);
+			raymultisamp(rv, 2, d, np->rp);
 			d = 2.0*PI * rv[0];
 			cosp = tcos(d);
 			sinp = tsin(d);
@@ -525,10 +525,10 @@ gaussamp(			/* sample Gaussian specular */
 		for (nstaken = ntrials = 0; nstaken < nstarget &&
 						ntrials < maxiter; ntrials++) {
 			if (ntrials)
-				d = frandom();
+				d = rayrand(np->rp);
 			else
-				d = urand(ilhash(dimlist,ndims)+samplendx);
-			multisamp(rv, 2, d);
+				d = rayurand(np->rp, ilhash(dimlist,ndims)+(int)np->rp->rkey);
+			raymultisamp(rv, 2, d, np->rp);
 			d = 2.0*PI * rv[0];
 			cosp = tcos(d);
 			sinp = tsin(d);
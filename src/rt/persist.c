@@ -32,6 +32,10 @@ static const char	RCSid[] = "$Id: persist.c,v 2.44 2016/03/06 01:13:18 schorsch
 #define TIMELIM		(8*3600)	/* time limit for holding pattern */
 #endif
 
+#ifndef PFTRIES
+#define PFTRIES		240		/* polls of empty persist file */
+#endif
+
 extern int	headismine;	/* boolean true if header belongs to me */
 extern char	*progname;	/* global program name */
 extern char	*errfile;	/* global error file name */
@@ -164,7 +168,11 @@ pfhold(void)		/* holding pattern for idle rendering process */
 	close(1);
 	if (open(outpname, O_WRONLY) != 1)
 		error(INTERNAL, "unexpected stdout file number");
-	sleep(3);		/* give them a chance to open their pipes */
+	/*
+	 * No need to wait here: each FIFO open blocks until the other
+	 * end is opened, so the client has all our pipes by now and
+	 * we may unlink them.
+	 */
 	if (errname[0]) {
 		close(2);
 		if (open(errname, O_WRONLY) != 2)
@@ -193,12 +201,12 @@ io_process(void)		/* just act as go-between for actual process */
 	int	status = 0;
 	fd_set	readfds, excepfds;
 					/* load persist file */
-	n = 40;
+	n = PFTRIES;
 	while ((nr = read(persistfd, buf, sizeof(buf)-1)) == 0) {
 		if (!n--)
 			error(USER, "unattended persist file?");
-		pflock(0);
-		sleep(3+(3*getpid()+random())%13);	/* wait until ready */
+		pflock(0);		/* renderer is between clients */
+		sleep(1+(3*getpid()+random())%3);	/* wait until ready */
 		pflock(1);
 	}
 	if (nr < 0)
@@ -22,6 +22,7 @@ static const char RCSid[] = "$Id: pmapbias.c,v 2.5 2016/05/17 17:39:47 rschregle
 #include "pmapbias.h"
 #include "pmap.h"
 #include "pmaprand.h"
+#include "random.h"
 
 
 
@@ -98,7 +99,7 @@ void squeuePartition (PhotonSearchQueueNode* squeue, unsigned lo,
 
 
 
-void biasComp (PhotonMap* pmap, COLOR irrad)
+void biasComp (PhotonMap* pmap, RAY* ray, COLOR irrad)
 /* Photon density estimate with bias compensation -- czech dis shit out! */
 {
    unsigned                i, numLo, numHi, numMid;
@@ -194,7 +195,7 @@ void biasComp (PhotonMap* pmap, COLOR irrad)
          p [i] = exp(-0.5 * d [i] * d [i] / irradVar [i]);
       }
       
-      if (pmapRandom(pmap -> randState) < colorAvg(p)) {
+      if (rayrand(ray) < colorAvg(p)) {
          /* Deviation is probably noise, so add mid irradiance to history */
          copycolor(histEnd -> irrad, irrad);
          totalWeight += histEnd++ -> weight = BIASCOMP_WGT((float)numMid);
@@ -263,7 +264,7 @@ void biasComp (PhotonMap* pmap, COLOR irrad)
 
 /* Volume bias compensation disabled (probably redundant) */
 #if 0
-void volumeBiasComp (PhotonMap* pmap, const RAY* ray, COLOR irrad)
+void volumeBiasComp (PhotonMap* pmap, RAY* ray, COLOR irrad)
 /* Photon volume density estimate with bias compensation -- czech dis 
    shit out! */
 {
@@ -381,7 +382,7 @@ void volumeBiasComp (PhotonMap* pmap, const RAY* ray, COLOR irrad)
          p [i] = exp(-0.5 * d [i] * d [i] / irradVar [i]);
       }
       
-      if (pmapRandom(pmap -> randState) < colorAvg(p)) {
+      if (rayrand(ray) < colorAvg(p)) {
          /* Deviation is probably noise, so add mid irradiance to history */
          copycolor(histEnd -> irrad, irrad);
          totalWeight += histEnd++ -> weight = BIASCOMP_WGT((float)numMid);
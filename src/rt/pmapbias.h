@@ -31,11 +31,11 @@
    /* Dump photon bandwidth for bias compensated density estimates */
    /* #define BIASCOMP_BWIDTH */
 
-   void biasComp (PhotonMap*, COLOR);
+   void biasComp (PhotonMap*, RAY*, COLOR);
    /* Photon density estimate with bias compensation, returning irradiance. 
       Expects photons in search queue after a kd-tree lookup. */
 
-   void volumeBiasComp (PhotonMap*, const RAY*, COLOR);   
+   void volumeBiasComp (PhotonMap*, RAY*, COLOR);   
    /* Photon volume density estimate with bias compensation, returning
       irradiance. Expects photons in search queue after a kd-tree lookup. */
 
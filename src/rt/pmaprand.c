@@ -29,8 +29,10 @@ static const char RCSid[] = "$Id: pmaprand.c,v 2.6 2017/08/14 21:12:10 rschregle
    - russian roulette.
    
    In addition, each photon map also has a local state randState used for
-   distribRatio during distribution and for bias compensation during
-   gathering.
+   distribRatio during distribution and for precomputation.  Bias
+   compensation during gathering draws from the lookup ray's own stream
+   (see rayrand() in ray.h) instead, so rendering does not depend on the
+   process count.
    
    The random seed randSeed can be added to each initial state with
    pmapSeed() so the RNGs can be externally seeded if necessary.
@@ -30,7 +30,10 @@
     * state, which is independently seeded for decorellation -- see
     * distribPhotons() and distribPhotonContrib().    
     * The pmapSeed() and pmapRandom() macros below can be adapted to
-    * platform-specific RNGs if necessary.  */
+    * platform-specific RNGs if necessary.
+    * Unlike the renderers' per-ray streams, these states are per process,
+    * so the distributed photons are repeatable for a given mkpmap -n but
+    * change with the number of subprocesses.  */
 #if defined(_WIN32) || defined(_WIN64)
    /* Use standard RNG without state management; the generated sequences
     * will be suboptimal */
@@ -186,7 +186,7 @@ void photonDensity (PhotonMap *pmap, RAY *ray, COLOR irrad)
    }
    else 
       /* Apply bias compensation to density estimate */
-      biasComp(pmap, irrad);
+      biasComp(pmap, ray, irrad);
 }
 
 
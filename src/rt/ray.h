@@ -63,6 +63,8 @@ typedef struct ray {
 	FULLXF	*rox;		/* object transformation */
 	int	*slights;	/* list of lights to test for scattering */
 	RNUMBER	rno;		/* unique ray number */
+	RNUMBER	rkey;		/* random stream key */
+	RNUMBER	rctr;		/* random stream counter */
 	OBJECT	robj;		/* intersected object number */
 	int	rsrc;		/* source we're aiming for */
 	float	rweight;	/* cumulative weight (for termination) */
@@ -87,6 +89,11 @@ typedef struct ray {
 #define  raydistance(r)	(bright((r)->mcol) > 0.5*bright((r)->rcol) ? \
 				(r)->rmt : (r)->rxt)
 
+				/* next value from ray's own stream */
+#define  rayrand(r)	ctrandom((r)->rkey, (r)->rctr++)
+#define  rayurand(r,i)	(urmask ? (urperm[(i)&urmask]+rayrand(r))/(urmask+1.) \
+				: rayrand(r))
+
 #define  rayreorient(r)	if ((r)->rflips & 1) flipsurface(r); else
 
 extern char  VersionID[];	/* Radiance version ID string */
@@ -99,6 +106,7 @@ extern OBJECT	nsceneobjs;	/* number of objects in our scene */
 
 extern RNUMBER	raynum;		/* next ray ID */
 extern RNUMBER	nrays;		/* total rays traced so far */
+extern RNUMBER	raykey;		/* seed for primary ray streams */
 
 extern OBJREC  Lamb;		/* a Lambertian surface */
 extern OBJREC  Aftplane;	/* aft clipping object */
@@ -134,6 +142,7 @@ extern int cuda_kmeans_clusters;		/* Number of clusters of ambient for k-means *
 extern int cuda_kmeans_iterations;		/* Maximum number of k-means iterations */
 extern double cuda_kmeans_threshold;	/* Fraction of seeds that must change cluster to continue k-means iteration */
 extern double cuda_kmeans_error;		/* Weighting of position in k-means error */
+extern int cpu_kmeans_seed;				/* Seed irradiance cache by k-means in CPU build */
 
 #ifdef REMOTE_VCA
 /* For OptiX remote VCA access */
@@ -259,6 +268,10 @@ extern int	ray_fifo_in(RAY *r);
 extern int	ray_fifo_flush(void);
 					/* defined in raytrace.c */
 extern int	rayorigin(RAY *r, int rt, const RAY *ro, const COLOR rc);
+extern void	rayseed(void);
+extern RNUMBER	raystream(RNUMBER n);
+extern void	raymultisamp(double t[], int n, double x, RAY *r);
+extern int	rayperpendicular(FVECT v, const FVECT nrm, RAY *r);
 extern void	rayclear(RAY *r);
 extern void	raytrace(RAY *r);
 extern void	rayhit(OBJECT *oset, RAY *r);
@@ -299,5 +312,8 @@ extern void	rpict(int seq, char *pout, char *zout, char *prvr);
 #ifdef __cplusplus
 }
 #endif
+
+#include  "raystats.h"
+
 #endif /* _RAD_RAY_H_ */
 
@@ -161,6 +161,7 @@ reset_random(void)		/* re-initialize random number generator */
 {
 	if (rand_samp) {
 		srandom((long)time(0));
+		rayseed();
 		initurand(0);
 	} else {
 		srandom(0L);
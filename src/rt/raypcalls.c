@@ -477,6 +477,9 @@ ray_popen(			/* open the specified # processes */
 			}
 			close(p0[0]); close(p1[1]);
 			close(0);	/* don't share stdin */
+			if (rand_samp)	/* own primary ray streams */
+				rayseed();
+			RS_INIT();	/* own statistics */
 					/* following call never returns */
 			ray_pchild(p1[0], p0[1]);
 		}
@@ -0,0 +1,140 @@
+#ifndef lint
+static const char RCSid[] = "$Id$";
+#endif
+/*
+ *  raystats.c - optional per-stage statistics for the ray tracer.
+ *
+ *  Compile with -DRAYSTATS to enable.  Each process prints a summary
+ *  to stderr as it exits, or appends a JSON record to the file named
+ *  by the RAYSTATS environment variable if it is set.
+ */
+
+#include "copyright.h"
+
+#include <time.h>
+
+#include "ray.h"
+#include "otypes.h"
+#include "rtprocess.h"	/* getpid() */
+
+#ifdef RAYSTATS
+
+#if NUMOTYPE > RS_NOTYPES
+#error "RS_NOTYPES too small for object types"
+#endif
+
+extern char	*progname;	/* global argv[0] */
+
+RSTATS		rstats;		/* our statistics */
+
+static int	rs_done = 0;	/* already reported? */
+
+
+double
+rs_clock(void)			/* get elapsed seconds */
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec + 1e-9*ts.tv_nsec);
+#else
+	return((double)clock()/CLOCKS_PER_SEC);
+#endif
+}
+
+
+void
+rs_init(void)			/* start statistics for this process */
+{
+	static int	registered = 0;
+
+	memset(&rstats, 0, sizeof(rstats));
+	rstats.rays0 = nrays;
+	rstats.start = rs_clock();
+	rs_done = 0;
+	if (!registered++)
+		atexit(rs_report);
+}
+
+
+static void
+rs_json(FILE *fp, double elapsed)	/* write statistics as JSON record */
+{
+	int	i, n;
+
+	fprintf(fp, "{\"program\": \"%s\", \"pid\": %d, ",
+			progname != NULL ? progname : "unknown", (int)getpid());
+	fprintf(fp, "\"elapsed\": %.6f, \"io_time\": %.6f, ",
+			elapsed, rstats.iotime);
+	fprintf(fp, "\"rays\": %lu, \"voxels\": %lu, \"object_tests\": {",
+			(unsigned long)(nrays - rstats.rays0), (unsigned long)rstats.voxels);
+	for (i = n = 0; i < NUMOTYPE; i++)
+		if (rstats.otests[i])
+			fprintf(fp, "%s\"%s\": %lu", n++ ? ", " : "",
+					ofun[i].funame,
+					(unsigned long)rstats.otests[i]);
+	fprintf(fp, "}, \"shadow_rays\": %lu, \"shadow_cache_tests\": %lu, ",
+			(unsigned long)rstats.shadows,
+			(unsigned long)rstats.sbtests);
+	fprintf(fp, "\"shadow_cache_hits\": %lu, ",
+			(unsigned long)rstats.sbhits);
+	fprintf(fp, "\"ambient_lookups\": %lu, \"ambient_tests\": %lu, ",
+			(unsigned long)rstats.amblookups,
+			(unsigned long)rstats.ambtests);
+	fprintf(fp, "\"ambient_rejects\": %lu, \"ambient_inserts\": %lu, ",
+			(unsigned long)(rstats.ambtests - rstats.ambused),
+			(unsigned long)rstats.ambinserts);
+	fprintf(fp, "\"bsdf_queries\": %lu, \"function_evals\": %lu}\n",
+			(unsigned long)rstats.bsdfq,
+			(unsigned long)rstats.funcevals);
+}
+
+
+void
+rs_report(void)			/* report statistics for this process */
+{
+	double	elapsed = rs_clock() - rstats.start;
+	char	*fname = getenv("RAYSTATS");
+	FILE	*fp;
+	int	i;
+
+	if (rs_done++ || rstats.start <= 0)
+		return;
+	if (fname != NULL && *fname) {
+		if ((fp = fopen(fname, "a")) == NULL) {
+			sprintf(errmsg, "cannot append statistics to \"%s\"",
+					fname);
+			error(WARNING, errmsg);
+			return;
+		}
+		rs_json(fp, elapsed);
+		fclose(fp);
+		return;
+	}
+	fprintf(stderr, "%s: statistics for process %d:\n",
+			progname != NULL ? progname : "unknown", (int)getpid());
+	fprintf(stderr, "\t%.3f seconds elapsed, %.3f seconds of I/O\n",
+			elapsed, rstats.iotime);
+	fprintf(stderr, "\t%lu rays traced, %lu octree voxels visited\n",
+			(unsigned long)(nrays - rstats.rays0), (unsigned long)rstats.voxels);
+	for (i = 0; i < NUMOTYPE; i++)
+		if (rstats.otests[i])
+			fprintf(stderr, "\t%lu %s tests\n",
+					(unsigned long)rstats.otests[i],
+					ofun[i].funame);
+	fprintf(stderr, "\t%lu shadow rays, %lu of %lu shadow cache checks hit\n",
+			(unsigned long)rstats.shadows,
+			(unsigned long)rstats.sbhits,
+			(unsigned long)rstats.sbtests);
+	fprintf(stderr, "\t%lu ambient lookups, %lu of %lu values rejected, %lu inserted\n",
+			(unsigned long)rstats.amblookups,
+			(unsigned long)(rstats.ambtests - rstats.ambused),
+			(unsigned long)rstats.ambtests,
+			(unsigned long)rstats.ambinserts);
+	fprintf(stderr, "\t%lu BSDF queries, %lu function evaluations\n",
+			(unsigned long)rstats.bsdfq,
+			(unsigned long)rstats.funcevals);
+}
+
+#endif /* RAYSTATS */
@@ -0,0 +1,68 @@
+/* RCSid $Id$ */
+/*
+ *  raystats.h - optional per-stage statistics for the ray tracer.
+ *
+ *  Counters and timers are only compiled in when RAYSTATS is defined,
+ *  otherwise all of the macros below expand to nothing.  Statistics
+ *  are kept per process, since that is how renderings are parallelized,
+ *  and reported when each process exits.
+ *
+ *  Include after ray.h
+ */
+#ifndef _RAD_RAYSTATS_H_
+#define _RAD_RAYSTATS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RAYSTATS
+
+#define RS_NOTYPES	64		/* >= NUMOTYPE, checked in raystats.c */
+
+typedef struct {
+	RNUMBER	voxels;			/* octree cells visited */
+	RNUMBER	otests[RS_NOTYPES];	/* object tests by type */
+	RNUMBER	shadows;		/* shadow rays traced */
+	RNUMBER	sbtests;		/* shadow cache checks */
+	RNUMBER	sbhits;			/* shadow cache hits */
+	RNUMBER	amblookups;		/* ambient cache lookups */
+	RNUMBER	ambtests;		/* ambient values considered */
+	RNUMBER	ambused;		/* ambient values interpolated */
+	RNUMBER	ambinserts;		/* ambient values inserted */
+	RNUMBER	bsdfq;			/* BSDF evaluations and samples */
+	RNUMBER	funcevals;		/* texture/pattern/function setups */
+	double	iotime;			/* seconds reading and writing */
+	RNUMBER	rays0;			/* nrays at initialization */
+	double	start;			/* time at initialization */
+} RSTATS;
+
+extern RSTATS	rstats;
+
+extern double	rs_clock(void);
+extern void	rs_init(void);
+extern void	rs_report(void);
+
+#define RS_COUNT(c)	(rstats.c++)
+#define RS_ADD(c,n)	(rstats.c += (n))
+#define RS_OTEST(t)	(rstats.otests[t]++)
+#define RS_BEGIN(t)	(rstats.t -= rs_clock())
+#define RS_END(t)	(rstats.t += rs_clock())
+#define RS_INIT()	rs_init()
+#define RS_REPORT()	rs_report()
+
+#else
+
+#define RS_COUNT(c)
+#define RS_ADD(c,n)
+#define RS_OTEST(t)
+#define RS_BEGIN(t)
+#define RS_END(t)
+#define RS_INIT()
+#define RS_REPORT()
+
+#endif /* RAYSTATS */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _RAD_RAYSTATS_H_ */
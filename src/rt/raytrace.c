@@ -9,6 +9,9 @@ static const char RCSid[] = "$Id: raytrace.c,v 2.81 2020/03/29 18:21:57 greg Exp
 
 #include "copyright.h"
 
+#include  <time.h>
+
+#include  "rtprocess.h" /* getpid() */
 #include  "ray.h"
 #include  "source.h"
 #include  "otypes.h"
@@ -20,6 +23,7 @@ static const char RCSid[] = "$Id: raytrace.c,v 2.81 2020/03/29 18:21:57 greg Exp
 
 RNUMBER  raynum = 0;		/* next unique ray number */
 RNUMBER  nrays = 0;		/* number of calls to localhit */
+RNUMBER  raykey = 0;		/* seed for primary ray streams */
 
 static RREAL  Lambfa[5] = {PI, PI, PI, 0.0, 0.0};
 OBJREC  Lamb = {
@@ -33,7 +37,64 @@ OBJREC  Aftplane;			/* aft clipping plane object */
 
 static int raymove(FVECT  pos, OBJECT  *cxs, int  dirf, RAY  *r, CUBE  *cu);
 static int checkhit(RAY  *r, CUBE  *cu, OBJECT  *cxs);
-static void checkset(OBJECT  *os, OBJECT  *cs);
+static void checkset(OBJECT  *oset, const OBJECT  *os, OBJECT  *cs);
+
+
+void
+rayseed(void)			/* pick primary streams for this process */
+{
+	raykey = ctrhash((unsigned long)time(0), (unsigned long)getpid());
+}
+
+
+RNUMBER
+raystream(			/* random stream key for primary ray n */
+	RNUMBER  n
+)
+{
+	if (!rand_samp)			/* repeatable given ray order */
+		return(n);
+	return(ctrhash(raykey, n));
+}
+
+
+void
+raymultisamp(			/* multisamp() jittered from ray's stream */
+	double  t[],
+	int  n,
+	double  x,
+	RAY  *r
+)
+{
+	double	jit[8];
+	int	i;
+
+	for (i = 0; i < n; i++)
+		jit[i] = rayrand(r);
+	multisampj(t, n, x, jit);
+}
+
+
+int
+rayperpendicular(		/* perpendicular turned by ray's stream */
+	FVECT  v,
+	const FVECT  nrm,
+	RAY  *r
+)
+{
+	FVECT	u, w;
+	double	a, ca, sa;
+	int	i;
+
+	if (!getperpendicular(u, nrm, 0))
+		return(0);
+	VCROSS(w, nrm, u);
+	a = 2.*PI*rayrand(r);
+	ca = cos(a); sa = sin(a);
+	for (i = 3; i--; )
+		v[i] = ca*u[i] + sa*w[i];
+	return(1);
+}
 
 
 int
@@ -105,6 +166,12 @@ rayorigin(		/* start new ray from old one */
 		}
 	}
 	rayclear(r);
+						/* private random stream */
+	if (ro == NULL)
+		r->rkey = raystream(r->rno);
+	else				/* parent's counter is mutable */
+		r->rkey = ctrhash(ro->rkey, ((RAY *)ro)->rctr++);
+	r->rctr = 0;
 	if (r->rweight <= 0.0)			/* check for expiration */
 		return(-1);
 	if (r->crtype & SHADOW)			/* shadow commitment */
@@ -123,7 +190,7 @@ rayorigin(		/* start new ray from old one */
 			return(-1);		/* upper reflection limit */
 		if (r->rweight >= minweight)
 			return(0);
-		if (frandom() > r->rweight/minweight)
+		if (rayrand(r) > r->rweight/minweight)
 			return(-1);
 		rw = minweight/r->rweight;	/* promote survivor */
 		scalecolor(r->rcoef, rw);
@@ -539,6 +606,7 @@ rayhit(			/* standard ray hit test */
 
 	for (i = oset[0]; i > 0; i--) {
 		o = objptr(oset[i]);
+		RS_OTEST(o->otype);
 		if ((*ofun[o->otype].funp)(o, r))
 			r->robj = oset[i];
 	}
@@ -558,6 +626,7 @@ localhit(		/* check for hit in the octree */
 	int  i;
 
 	nrays++;			/* increment trace counter */
+	RS_ADD(shadows, (r->crtype & SHADOW) != 0);
 	sflags = 0;
 	for (i = 0; i < 3; i++) {
 		curpos[i] = r->rorg[i];
@@ -620,6 +689,7 @@ raymove(		/* check for hit as we move */
 	int  ax;
 	double  dt, t;
 
+	RS_COUNT(voxels);
 	if (istree(cu->cutree)) {		/* recurse on subcubes */
 		CUBE  cukid;
 		int  br, sgn;
@@ -702,8 +772,8 @@ checkhit(		/* check for hit in full cube */
 {
 	OBJECT  oset[MAXSET+1];
 
-	objset(oset, cu->cutree);
-	checkset(oset, cxs);			/* avoid double-checking */
+						/* avoid double-checking */
+	checkset(oset, objsetp(cu->cutree), cxs);
 
 	(*r->hitf)(oset, r);			/* test for hit in set */
 
@@ -715,33 +785,36 @@ checkhit(		/* check for hit in full cube */
 
 
 static void
-checkset(		/* modify checked set and set to check */
-	OBJECT  *os,			/* os' = os - cs */
+checkset(		/* get set to check and modify checked set */
+	OBJECT  *oset,			/* oset = os - cs */
+	const OBJECT  *os,		/* node set, read in place */
 	OBJECT  *cs			/* cs' = cs + os */
 )
 {
 	OBJECT  cset[MAXCSET+MAXSET+1];
 	int  i, j;
-	int  k;
-					/* copy os in place, cset <- cs */
+	int  k, n0 = 0;
+					/* oset <- os - cs, cset <- cs + os */
 	cset[0] = 0;
 	k = 0;
 	for (i = j = 1; i <= os[0]; i++) {
 		while (j <= cs[0] && cs[j] < os[i])
 			cset[++cset[0]] = cs[j++];
 		if (j > cs[0] || os[i] != cs[j]) {	/* object to check */
-			os[++k] = os[i];
+			if (!k)
+				n0 = cset[0];	/* cs is unchanged this far */
+			oset[++k] = os[i];
 			cset[++cset[0]] = os[i];
 		}
 	}
-	if (!(os[0] = k))		/* new "to check" set size */
+	if (!(oset[0] = k))		/* new "to check" set size */
 		return;			/* special case */
 	while (j <= cs[0])		/* get the rest of cs */
 		cset[++cset[0]] = cs[j++];
 	if (cset[0] > MAXCSET)		/* truncate "checked" set if nec. */
 		cset[0] = MAXCSET;
-	/* setcopy(cs, cset); */	/* copy cset back to cs */
-	os = cset;
-	for (i = os[0]; i-- >= 0; )
-		*cs++ = *os++;
+					/* copy changed part back to cs */
+	for (i = n0+1; i <= cset[0]; i++)
+		cs[i] = cset[i];
+	cs[0] = cset[0];
 }
@@ -260,31 +260,37 @@ getvec(FVECT vec)
 	float	vf[3];
 	double	vd[3];
 	char	buf[32];
-	int	i;
+	int	i, rv = 0;
 
+	RS_BEGIN(iotime);
 	switch (inpfmt) {
 	case 'a':					/* ascii */
 		for (i = 0; i < 3; i++) {
 			if (fgetword(buf, sizeof(buf), stdin) == NULL ||
-					!isflt(buf))
-				return(-1);
+					!isflt(buf)) {
+				rv = -1;
+				break;
+			}
 			vec[i] = atof(buf);
 		}
 		break;
 	case 'f':					/* binary float */
 		if (getbinary((char *)vf, sizeof(float), 3, stdin) != 3)
-			return(-1);
-		VCOPY(vec, vf);
+			rv = -1;
+		else
+			VCOPY(vec, vf);
 		break;
 	case 'd':					/* binary double */
 		if (getbinary((char *)vd, sizeof(double), 3, stdin) != 3)
-			return(-1);
-		VCOPY(vec, vd);
+			rv = -1;
+		else
+			VCOPY(vec, vd);
 		break;
 	default:
 		error(CONSISTENCY, "botched input format");
 	}
-	return(0);
+	RS_END(iotime);
+	return(rv);
 }
 
 
@@ -381,6 +387,7 @@ void
 end_record()
 {
 	--waitflush;
+	RS_BEGIN(iotime);
 	lu_doall(&ofiletab, &puteol, NULL);
 	if (using_stdout & (outfmt == 'a'))
 		putc('\n', stdout);
@@ -389,6 +396,7 @@ end_record()
 		if (using_stdout)
 			fflush(stdout);
 	}
+	RS_END(iotime);
 }
 
 /************************** PARTIAL RESULTS RECOVERY ***********************/
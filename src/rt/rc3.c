@@ -298,6 +298,8 @@ in_rchild()
 				waitflush = xres = 0;
 				account = accumulate = 0;
 			}
+			if (rand_samp)	/* own primary ray streams */
+				rayseed();
 			return(1);	/* return "true" in child */
 		}
 		if (rval != PIPE_BUF)
@@ -362,6 +362,7 @@ main(int argc, char *argv[])
 					/* initialize urand */
 	if (rand_samp) {
 		srandom((long)time(0));
+		rayseed();
 		initurand(0);
 	} else {
 		srandom(0L);
@@ -402,7 +403,7 @@ main(int argc, char *argv[])
 	/* PMAP: set up & load photon maps */
 	ray_init_pmap();     
 	
-#ifdef ACCELERAD
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
 	if (!use_optix) /* Don't shoot rays here, since the OptiX program should handle this. */
 #endif
 	marksources();			/* find and mark sources */
@@ -72,6 +72,15 @@ static void mcfree(void *p) { epfree((*(MODCONT *)p).binv); free(p); }
 
 LUTAB	modconttab = LU_SINIT(NULL,mcfree);	/* modifier lookup table */
 
+#ifndef MCACHESIZ
+#define MCACHESIZ	257		/* modifier cache size (prime) */
+#endif
+
+static struct {
+	OBJECT	mod;			/* modifier object + 1, 0 if unused */
+	MODCONT	*mp;			/* its entry, NULL if not tracked */
+} modcache[MCACHESIZ];		/* saves hashing names on each hit */
+
 #ifdef ACCELERAD
 #define EXPECTED_RAY_COUNT	32
 
@@ -121,6 +130,7 @@ addmodifier(char *modn, char *outf, char *prms, char *binv, int bincnt)
 		sprintf(errmsg, "cannot track '%s' modifier", VOIDID);
 		error(USER, errmsg);
 	}
+	memset(modcache, 0, sizeof(modcache));
 	modname[nmods++] = modn;	/* XXX assumes static string */
 	lep->key = modn;		/* XXX assumes static string */
 	if (binv == NULL)
@@ -255,6 +265,21 @@ rcinit(void)
 
 /************************** MAIN CALCULATION PROCESS ***********************/
 
+/* Find contribution record for a modifier object */
+static MODCONT *
+getmodcont(OBJECT mod)
+{
+	const int	h = mod % MCACHESIZ;
+
+	if (modcache[h].mod != mod+1) {
+		modcache[h].mp = (MODCONT *)lu_find(&modconttab,
+						objptr(mod)->oname)->data;
+		modcache[h].mod = mod+1;
+	}
+	return(modcache[h].mp);
+}
+
+
 /* Our trace call to sum contributions */
 static void
 trace_contrib(RAY *r)
@@ -270,7 +295,7 @@ trace_contrib(RAY *r)
 	if (r->rsrc >= 0 && source[r->rsrc].so != r->ro)
 		return;
 
-	mp = (MODCONT *)lu_find(&modconttab,objptr(r->ro->omod)->oname)->data;
+	mp = getmodcont(r->ro->omod);
 
 	if (mp == NULL)				/* not in our list? */
 		return;
@@ -292,7 +317,11 @@ trace_contrib(RAY *r)
 
 
 /* Evaluate irradiance contributions */
+#ifdef ACCELERAD
+void
+#else
 static void
+#endif
 eval_irrad(FVECT org, FVECT dir)
 {
 	RAY	thisray;
@@ -314,7 +343,11 @@ eval_irrad(FVECT org, FVECT dir)
 
 
 /* Evaluate radiance contributions */
+#ifdef ACCELERAD
+void
+#else
 static void
+#endif
 eval_rad(FVECT org, FVECT dir, double dmax)
 {
 	RAY	thisray;
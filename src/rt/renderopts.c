@@ -36,6 +36,7 @@ int cuda_kmeans_clusters = 4096;		/* Number of clusters of ambient for k-means (
 int cuda_kmeans_iterations = 100;		/* Maximum number of k-means iterations (-an) */
 double cuda_kmeans_threshold = 0.05;	/* Fraction of seeds that must change cluster to continue k-means iteration (-at) */
 double cuda_kmeans_error = 1.0;			/* Weighting of position in k-means error (-ax) */
+int cpu_kmeans_seed = 0;				/* Seed irradiance cache by k-means in CPU build (-ak) */
 
 #ifdef REMOTE_VCA
 /* For OptiX remote VCA access */
@@ -245,6 +246,9 @@ getrenderopt(		/* get next render option */
 			check(3,"f");
 			cuda_kmeans_error = atof(av[1]);
 			return(1);
+		case 'k':				/* Seed irradiance cache by k-means in CPU build */
+			check_bool(3,cpu_kmeans_seed);
+			return(0);
 #endif
 		case 'i':				/* include */
 		case 'I':
@@ -373,6 +377,8 @@ print_rdefaults(void)		/* print default render values to stdout */
 	printf("-an %-9d\t\t\t# ambient k-means iterations (GPU only)\n", cuda_kmeans_iterations);
 	printf("-at %f\t\t\t# ambient k-means threshold (GPU only)\n", cuda_kmeans_threshold);
 	printf("-ax %f\t\t\t# ambient k-means weighting factor (GPU only)\n", cuda_kmeans_error);
+	printf(cpu_kmeans_seed ? "-ak+\t\t\t\t# ambient k-means seeding on (CPU only)\n" :
+			"-ak-\t\t\t\t# ambient k-means seeding off (CPU only)\n");
 #endif
 	printf("-me %.2e %.2e %.2e\t# mist extinction coefficient\n",
 			colval(cextinction,RED),
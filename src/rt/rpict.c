@@ -28,6 +28,9 @@ static const char RCSid[] = "$Id: rpict.c,v 2.93 2019/05/04 00:32:47 greg Exp $"
 #include  <signal.h>
 
 #include  "ray.h"
+#include  "source.h"
+#include  "rtprocess.h"
+#include  "selcall.h"
 #include  "paths.h"
 #include  "ambient.h"
 #include  "view.h"
@@ -113,18 +116,32 @@ int  ambincl = -1;			/* include == 1, exclude == 0 */
 
 int  ralrm = 0;				/* seconds between reports */
 
+int  nproc = 1;				/* number of rendering processes */
+
+int  progtime = 0;			/* progressive time budget (sec.) */
+
 double	pctdone = 0.0;			/* percentage done */
 time_t  tlastrept = 0L;			/* time at last report */
 time_t  tstart;				/* starting time */
 
 #define	 MAXDIV		16		/* maximum sample size */
 
+#define	 BANDHT		32		/* nominal scanlines per band */
+#define	 MAXKIDS	128		/* maximum rendering processes */
+#define	 MAXAHEAD	4		/* bands ahead of output per process */
+#define	 PROGRES	64		/* samples across first progressive pass */
+
 #define	 pixjitter()	(.5+dstrpix*(.5-frandom()))
 
 int  hres, vres;			/* resolution for this frame */
 
 static VIEW	lastview;		/* the previous view input */
 
+extern int  headismine;			/* boolean true if header is mine */
+
+static int  nscans = 0;			/* scanlines filled this band */
+static unsigned  pixseed = 0;		/* random seed offset for pixels */
+
 #ifdef ACCELERAD
 void reportProgress(double percent);
 #endif
@@ -137,7 +154,22 @@ static void fillscanbar(COLOR *scanbar[], float *zbar[], int xres,
 		int y, int ysize);
 static int fillsample(COLOR *colline, float *zline, int x, int y,
 		int xlen, int ylen, int b);
+static int renderband(COLOR *scanbar[], float *zbar[], char *sd,
+		int ytop, int yend, int hstep, int ystep,
+		COLOR *cout, float *zout);
+static int writeband(COLOR *cbuf, float *zbuf, int nrows, int zfd);
+static void renderkids(int nkids, COLOR *scanbar[], float *zbar[], char *sd,
+		COLOR *cbuf, float *zbuf, int ypos, int bandht,
+		int hstep, int ystep, int zfd);
+static int progressive(COLOR *scanline, float *zline, int zfd);
+static int blockdiff(COLOR *pcol, float *pz, int x0, int y0, int x1, int y1);
+static int progwrite(COLOR *pcol, float *pz, unsigned char *plev, int step,
+		int final, COLOR *scanline, float *zline, long hdrend, int zfd);
+#ifdef ACCELERAD
+double pixvalue(COLOR  col, int  x, int  y);
+#else
 static double pixvalue(COLOR  col, int  x, int  y);
+#endif
 static int salvage(char  *oldfile);
 static int pixnumber(int  x, int  y, int  xres, int  yres);
 
@@ -258,6 +290,10 @@ rpict(			/* generate image(s) */
 		error(WARNING, errmsg);
 		psample = MAXDIV;
 	}
+#ifdef ACCELERAD_CPU
+	if (psample > 1)		/* batches don't subsample */
+		use_optix = 0;
+#endif
 					/* get starting frame */
 	if (seq <= 0)
 		seq = 0;
@@ -404,6 +440,10 @@ render(				/* render the scene */
 	COLOR  *scanbar[MAXDIV+1];	/* scanline arrays of pixel values */
 	float  *zbar[MAXDIV+1];		/* z values */
 	char  *sampdens;		/* previous sample density */
+	COLOR  *bandcol = NULL;		/* band of pixel values */
+	float  *bandz = NULL;		/* band of z values */
+	int  bandht;			/* band height */
+	int  nbands, band, n;
 	int  ypos;			/* current scanline */
 	int  ystep;			/* current y step size */
 	int  hstep;			/* h step size */
@@ -447,6 +487,7 @@ render(				/* render the scene */
 
 		/* Quick output handling */
 		fprtresolu(hres, vres, stdout);
+		RS_BEGIN(iotime);
 		for (i = vres; i--;) {
 			if (zfd != -1 && write(zfd, (char *)(zptr + hres * i), hres * sizeof(float)) < hres * sizeof(float))
 				goto writerr;
@@ -454,6 +495,7 @@ render(				/* render the scene */
 			if (fflush(stdout) == EOF)
 				goto writerr;
 		}
+		RS_END(iotime);
 
 		/* Unallocate the memory that was used to save the output transfered back from OptiX rendering. */
 		free(colptr);
@@ -475,10 +517,9 @@ render(				/* render the scene */
 		i = hres/hstep + 2;
 		if ((sampdens = (char *)malloc(i)) == NULL)
 			goto memerr;
-		while (i--)
-			sampdens[i] = hstep;
 	} else
 		sampdens = NULL;
+	bandht = (BANDHT+ystep-1)/ystep*ystep;	/* whole bars per band */
 					/* open z-file */
 	if (zfile != NULL) {
 		if ((zfd = open(zfile, O_WRONLY|O_CREAT, 0666)) == -1) {
@@ -491,11 +532,17 @@ render(				/* render the scene */
 			if (zbar[i] == NULL)
 				goto memerr;
 		}
+		bandz = (float *)malloc((bandht+1)*hres*sizeof(float));
+		if (bandz == NULL)
+			goto memerr;
 	} else {
 		zfd = -1;
 		for (i = 0; i <= psample; i++)
 			zbar[i] = NULL;
 	}
+	bandcol = (COLOR *)malloc((bandht+1)*hres*sizeof(COLOR));
+	if (bandcol == NULL)
+		goto memerr;
 					/* write out boundaries */
 	fprtresolu(hres, vres, stdout);
 					/* recover file and compute first */
@@ -513,45 +560,31 @@ render(				/* render the scene */
 	signal(SIGCONT, report);
 #endif
 	ypos = vres-1 - i;			/* initialize sampling */
+	nbands = ypos > 0 ? (ypos-1)/bandht + 1 : 1;
+	pixseed = rand_samp ? (unsigned)random() : 0;
 	if (directvis)
 		init_drawsources(psample);
-	fillscanline(scanbar[0], zbar[0], sampdens, hres, ypos, hstep);
-						/* compute scanlines */
-	for (ypos -= ystep; ypos > -ystep; ypos -= ystep) {
-							/* bottom adjust? */
-		if (ypos < 0) {
-			ystep += ypos;
-			ypos = 0;
-		}
-		colptr = scanbar[ystep];		/* move base to top */
-		scanbar[ystep] = scanbar[0];
-		scanbar[0] = colptr;
-		zptr = zbar[ystep];
-		zbar[ystep] = zbar[0];
-		zbar[0] = zptr;
-							/* fill base line */
-		fillscanline(scanbar[0], zbar[0], sampdens,
-				hres, ypos, hstep);
-							/* fill bar */
-		fillscanbar(scanbar, zbar, hres, ypos, ystep);
-		if (directvis)				/* add bitty sources */
-			drawsources(scanbar, zbar, 0, hres, ypos, ystep);
+	if (progtime > 0) {			/* progressive refinement */
+		if (progressive(scanbar[0], zbar[0], zfd) < 0)
+			goto writerr;
+		goto alldone;
+	}
+	if ((nproc > 1) & (nbands > 1)) {	/* farm out bands */
+		renderkids(nproc < nbands ? nproc : nbands, scanbar, zbar,
+				sampdens, bandcol, bandz, ypos, bandht,
+				hstep, ystep, zfd);
+		goto alldone;
+	}
+	for (band = 0; band < nbands; band++) {	/* compute bands */
+		i = ypos - band*bandht;
+		n = renderband(scanbar, zbar, sampdens, i,
+				i > bandht ? i-bandht : 0, hstep, ystep,
+				bandcol, zfd != -1 ? bandz : (float *)NULL);
 							/* write it out */
-#ifdef SIGCONT
-		signal(SIGCONT, SIG_IGN);	/* don't interrupt writes */
-#endif
-		for (i = ystep; i > 0; i--) {
-			if (zfd != -1 && write(zfd, (char *)zbar[i],
-					hres*sizeof(float))
-					< hres*sizeof(float))
-				goto writerr;
-			if (fwritescan(scanbar[i], hres, stdout) < 0)
-				goto writerr;
-		}
-		if (fflush(stdout) == EOF)
+		if (writeband(bandcol, bandz, n, zfd) < 0)
 			goto writerr;
 							/* record progress */
-		pctdone = 100.0*(vres-1-ypos)/vres;
+		pctdone = 100.0*(vres-1-i+n)/vres;
 		if (ralrm > 0 && time((time_t *)NULL) >= tlastrept+ralrm)
 			report(0);
 #ifdef SIGCONT
@@ -559,25 +592,19 @@ render(				/* render the scene */
 			signal(SIGCONT, report);
 #endif
 	}
-						/* clean up */
-#ifdef SIGCONT
-	signal(SIGCONT, SIG_IGN);
-#endif
-	if (zfd != -1 && write(zfd, (char *)zbar[0], hres*sizeof(float))
-				< hres*sizeof(float))
-		goto writerr;
-	fwritescan(scanbar[0], hres, stdout);
-	if (fflush(stdout) == EOF)
-		goto writerr;
 alldone:
 	if (zfd != -1) {
 		if (close(zfd) == -1)
 			goto writerr;
 		for (i = 0; i <= psample; i++)
 			free((void *)zbar[i]);
+		if (bandz != NULL)
+			free((void *)bandz);
 	}
 	for (i = 0; i <= psample; i++)
 		free((void *)scanbar[i]);
+	if (bandcol != NULL)
+		free((void *)bandcol);
 	if (sampdens != NULL)
 		free(sampdens);
 	pctdone = 100.0;
@@ -594,6 +621,266 @@ memerr:
 }
 
 
+static int
+renderband(		/* render scanlines ytop through yend */
+	COLOR	*scanbar[],
+	float	*zbar[],
+	char  *sd,
+	int  ytop,
+	int  yend,
+	int  hstep,
+	int  ystep,
+	COLOR  *cout,
+	float  *zout
+)
+/*
+ * The base scanline at yend is computed but only returned if it
+ * is the bottom of the picture, since it is also the top of the next
+ * band.  Sampling state is reset here and random state for each pixel
+ * in pixvalue(), so a band's pixels do not depend on which process
+ * renders it or in what order.
+ */
+{
+	COLOR  *colptr;
+	float  *zptr;
+	int  ypos, n, i;
+					/* reset sampling state */
+	for (i = nsources; i-- > 0; ) {
+		source[i].nhits = 1;
+		source[i].ntests = 2;
+#if SHADCACHE
+		freeobscache(&source[i]);
+#endif
+	}
+	nscans = 0;
+	if (sd != NULL)
+		for (i = hres/hstep + 2; i--; )
+			sd[i] = hstep;
+	fillscanline(scanbar[0], zbar[0], sd, hres, ytop, hstep);
+	n = 0;
+	for (ypos = ytop-ystep; ypos > yend-ystep; ypos -= ystep) {
+		if (ypos < yend) {			/* bottom adjust */
+			ystep += ypos - yend;
+			ypos = yend;
+		}
+		colptr = scanbar[ystep];		/* move base to top */
+		scanbar[ystep] = scanbar[0];
+		scanbar[0] = colptr;
+		zptr = zbar[ystep];
+		zbar[ystep] = zbar[0];
+		zbar[0] = zptr;
+							/* fill base line */
+		fillscanline(scanbar[0], zbar[0], sd, hres, ypos, hstep);
+							/* fill bar */
+		fillscanbar(scanbar, zbar, hres, ypos, ystep);
+		if (directvis)				/* add bitty sources */
+			drawsources(scanbar, zbar, 0, hres, ypos, ystep);
+		for (i = ystep; i > 0; i--, n++) {	/* copy out */
+			memcpy(cout+n*hres, scanbar[i], hres*sizeof(COLOR));
+			if (zout != NULL)
+				memcpy(zout+n*hres, zbar[i],
+						hres*sizeof(float));
+		}
+	}
+	if (yend == 0) {			/* bottom scanline */
+		memcpy(cout+n*hres, scanbar[0], hres*sizeof(COLOR));
+		if (zout != NULL)
+			memcpy(zout+n*hres, zbar[0], hres*sizeof(float));
+		n++;
+	}
+	return(n);
+}
+
+
+static int
+writeband(		/* write out rendered scanlines */
+	COLOR  *cbuf,
+	float  *zbuf,
+	int  nrows,
+	int  zfd
+)
+{
+	int  i;
+#ifdef SIGCONT
+	signal(SIGCONT, SIG_IGN);	/* don't interrupt writes */
+#endif
+	RS_BEGIN(iotime);
+	for (i = 0; i < nrows; i++) {
+		if (zfd != -1 && write(zfd, (char *)(zbuf+i*hres),
+				hres*sizeof(float))
+				< hres*sizeof(float))
+			break;
+		if (fwritescan(cbuf+i*hres, hres, stdout) < 0)
+			break;
+	}
+	if (i < nrows || fflush(stdout) == EOF)
+		nrows = -1;		/* write error */
+	RS_END(iotime);
+	return(nrows);
+}
+
+
+typedef struct s_bandq {
+	int		band;		/* band index */
+	int		nrows;		/* scanlines in band */
+	struct s_bandq	*next;		/* next in queue */
+	float		*zbuf;		/* z values (or NULL) */
+	COLOR		cbuf[1];	/* colors (extends struct) */
+} BANDQ;
+
+
+static void
+renderkids(		/* render bands using child processes */
+	int  nkids,
+	COLOR	*scanbar[],
+	float	*zbar[],
+	char  *sd,
+	COLOR  *cbuf,
+	float  *zbuf,
+	int  ypos,
+	int  bandht,
+	int  hstep,
+	int  ystep,
+	int  zfd
+)
+/*
+ * Bands are handed out to whichever child is free next, and the
+ * parent writes finished bands in order.  Since renderband() resets
+ * sampling state, the output does not depend on nkids.
+ */
+{
+	const int  nbands = ypos > 0 ? (ypos-1)/bandht + 1 : 1;
+	SUBPROC  kidpr[MAXKIDS];
+	int  kidband[MAXKIDS];
+	BANDQ  *outq = NULL, *bq, **bqp;
+	int  nextband = 0, nextout = 0;
+	fd_set  readset;
+	int  k, n, nr, ytop, yend;
+
+	if (nkids > MAXKIDS)
+		nkids = MAXKIDS;
+	fflush(stdout);				/* don't duplicate buffers */
+	for (k = 0; k < nkids; k++) {		/* fork children */
+		kidpr[k] = sp_inactive;
+		errno = 0;
+		n = open_process(&kidpr[k], NULL);
+		if (n < 0)
+			error(SYSTEM, "cannot fork rendering process");
+		if (n > 0) {
+			kidband[k] = -1;
+			continue;
+		}
+		headismine = 0;			/* in child */
+		ralrm = 0;
+		RS_INIT();			/* own statistics */
+#ifdef SIGCONT
+		signal(SIGCONT, SIG_IGN);
+#endif
+		while (k--) {			/* don't share other pipes */
+			close(kidpr[k].r);
+			close(kidpr[k].w);
+		}
+		while (readbuf(0, (char *)&n, sizeof(int)) == sizeof(int)) {
+			ytop = ypos - n*bandht;
+			yend = ytop > bandht ? ytop-bandht : 0;
+			nr = renderband(scanbar, zbar, sd, ytop, yend,
+					hstep, ystep, cbuf,
+					zfd != -1 ? zbuf : (float *)NULL);
+			if (writebuf(1, (char *)cbuf, nr*hres*sizeof(COLOR))
+					!= nr*hres*sizeof(COLOR))
+				error(SYSTEM, "write error in rendering process");
+			if (zfd != -1 && writebuf(1, (char *)zbuf,
+					nr*hres*sizeof(float))
+					!= nr*hres*sizeof(float))
+				error(SYSTEM, "write error in rendering process");
+		}
+		ambsync();			/* share ambient values */
+		quit(0);			/* child is done */
+	}
+	while (nextout < nbands) {
+						/* hand out more bands */
+		for (k = 0; k < nkids && nextband < nbands &&
+				nextband < nextout + MAXAHEAD*nkids; k++) {
+			if (kidband[k] >= 0)
+				continue;
+			if (writebuf(kidpr[k].w, (char *)&nextband,
+					sizeof(int)) != sizeof(int))
+				error(SYSTEM, "write error to rendering process");
+			kidband[k] = nextband++;
+		}
+		FD_ZERO(&readset);		/* wait for results */
+		n = 0;
+		for (k = nkids; k--; )
+			if (kidband[k] >= 0) {
+				FD_SET(kidpr[k].r, &readset);
+				if (kidpr[k].r >= n)
+					n = kidpr[k].r + 1;
+			}
+		errno = 0;
+		if (select(n, &readset, NULL, NULL, NULL) < 0) {
+			if (errno == EINTR)
+				continue;
+			error(SYSTEM, "select() error in renderkids()");
+		}
+		for (k = nkids; k--; ) {	/* collect finished bands */
+			if (kidband[k] < 0 || !FD_ISSET(kidpr[k].r, &readset))
+				continue;
+			ytop = ypos - kidband[k]*bandht;
+			yend = ytop > bandht ? ytop-bandht : 0;
+			nr = ytop - yend + (yend == 0);
+			bq = (BANDQ *)malloc(sizeof(BANDQ) +
+					sizeof(COLOR)*(nr*hres-1));
+			if (bq == NULL)
+				goto memerr;
+			bq->zbuf = NULL;
+			if (zfd != -1 && (bq->zbuf = (float *)malloc(
+					nr*hres*sizeof(float))) == NULL)
+				goto memerr;
+			if (readbuf(kidpr[k].r, (char *)bq->cbuf,
+					nr*hres*sizeof(COLOR)) !=
+					nr*hres*sizeof(COLOR))
+				error(USER, "rendering process died");
+			if (zfd != -1 && readbuf(kidpr[k].r, (char *)bq->zbuf,
+					nr*hres*sizeof(float)) !=
+					nr*hres*sizeof(float))
+				error(USER, "rendering process died");
+			bq->band = kidband[k];
+			bq->nrows = nr;
+			kidband[k] = -1;
+			for (bqp = &outq; *bqp != NULL &&
+					(*bqp)->band < bq->band;
+					bqp = &(*bqp)->next)
+				;
+			bq->next = *bqp;
+			*bqp = bq;
+		}
+						/* write bands in order */
+		while (outq != NULL && outq->band == nextout) {
+			bq = outq;
+			if (writeband(bq->cbuf, bq->zbuf, bq->nrows, zfd) < 0)
+				error(SYSTEM, "write error in render");
+			ytop = ypos - nextout*bandht;
+			pctdone = 100.0*(vres-1-ytop+bq->nrows)/vres;
+			if (ralrm > 0 && time((time_t *)NULL) >= tlastrept+ralrm)
+				report(0);
+#ifdef SIGCONT
+			else
+				signal(SIGCONT, report);
+#endif
+			outq = bq->next;
+			if (bq->zbuf != NULL)
+				free((void *)bq->zbuf);
+			free((void *)bq);
+			nextout++;
+		}
+	}
+	if (close_processes(kidpr, nkids) > 0)
+		error(WARNING, "rendering process returned bad status");
+	return;
+memerr:
+	error(SYSTEM, "out of memory in renderkids");
+}
+
 static void
 fillscanline(	/* fill scan at y */
 	COLOR	*scanline,
@@ -604,7 +891,6 @@ fillscanline(	/* fill scan at y */
 	int  xstep
 )
 {
-	static int  nc = 0;		/* number of calls */
 	int  bl = xstep, b = xstep;
 	double	z;
 	int  i;
@@ -612,7 +898,7 @@ fillscanline(	/* fill scan at y */
 	z = pixvalue(scanline[0], 0, y);
 	if (zline) zline[0] = z;
 				/* zig-zag start for quincunx pattern */
-	for (i = ++nc & 1 ? xstep : xstep/2; i < xres-1+xstep; i += xstep) {
+	for (i = ++nscans & 1 ? xstep : xstep/2; i < xres-1+xstep; i += xstep) {
 		if (i >= xres) {
 			xstep += xres-1-i;
 			i = xres-1;
@@ -626,10 +912,10 @@ fillscanline(	/* fill scan at y */
 			b = fillsample(scanline+i-xstep,
 					zline ? zline+i-xstep : (float *)NULL,
 					i-xstep, y, xstep, 0, b/2);
-		if (sd) *sd++ = nc & 1 ? bl : b;
+		if (sd) *sd++ = nscans & 1 ? bl : b;
 		bl = b;
 	}
-	if (sd && nc & 1) *sd = bl;
+	if (sd && nscans & 1) *sd = bl;
 }
 
 
@@ -722,7 +1008,206 @@ fillsample( /* fill interior points */
 }
 
 
+static int
+progressive(		/* render in refining passes until deadline */
+	COLOR	*scanline,
+	float	*zline,
+	int  zfd
+)
+{
+	COLOR  *pcol;			/* settled pixel values */
+	float  *pz;			/* settled z values */
+	unsigned char  *plev;		/* step at which pixel was settled */
+	char  *busy;			/* parent blocks needing samples */
+	time_t  tend;
+	long  hdrend;
+	int  s0, sfull, s, s2, nbx, nby;
+	int  x, y, x0, y0, x1, y1, bx, by, i;
+	int  npasses, stopped;
+	double	wx, wy, w;
+	COLOR  ctmp;
+
+	tend = time((time_t *)NULL) + progtime;
+	pcol = (COLOR *)malloc((size_t)hres*vres*sizeof(COLOR));
+	pz = (float *)malloc((size_t)hres*vres*sizeof(float));
+	plev = (unsigned char *)calloc((size_t)hres*vres, 1);
+	if ((pcol == NULL) | (pz == NULL) | (plev == NULL))
+		goto memerr;
+					/* rewrite picture after each pass? */
+	if (fflush(stdout) == EOF)
+		return(-1);
+	hdrend = ftell(stdout);		/* -1 if not seekable */
+	s0 = 1;				/* coarsest step */
+	while ((s0 < 128) & (s0*PROGRES < (hres > vres ? hres : vres)))
+		s0 <<= 1;
+	for (sfull = 1; sfull<<1 <= psample; sfull <<= 1)
+		;
+	for (npasses = 1, s = s0; s > 1; s >>= 1)
+		npasses++;
+	busy = (char *)malloc(((hres-1)/2+1)*((vres-1)/2+1));
+	if (busy == NULL)
+		goto memerr;
+					/* first pass on regular grid */
+	for (y = 0; y < vres; y += s0)
+		for (x = 0; x < hres; x += s0) {
+			i = y*hres + x;
+			pz[i] = pixvalue(pcol[i], x, y);
+			plev[i] = s0;
+		}
+	pctdone = 100./npasses;
+	for (s = s0, stopped = 0; ; ) {
+		if (progwrite(pcol, pz, plev, s, (s == 1) | stopped,
+				scanline, zline, hdrend, zfd) < 0)
+			return(-1);
+		if (ralrm > 0)
+			report(0);
+		if ((s == 1) | stopped)
+			break;		/* finished or out of time */
+		s2 = s; s >>= 1;
+		nbx = (hres-1)/s2 + 1;
+		nby = (vres-1)/s2 + 1;
+		/*
+		 * A parent block is refined if it lies above the -ps
+		 * sampling density, or if its corners differ by more
+		 * than -pt.  Otherwise its new points are interpolated.
+		 */
+		for (by = 0; by < nby; by++)
+			for (bx = 0; bx < nbx; bx++) {
+				x0 = bx*s2; y0 = by*s2;
+				x1 = x0+s2 < hres ? x0+s2 : x0;
+				y1 = y0+s2 < vres ? y0+s2 : y0;
+				busy[by*nbx+bx] = (s >= sfull) ||
+				blockdiff(pcol, pz, x0, y0, x1, y1);
+			}
+		for (y = 0; y < vres; y += s) {
+			if (time((time_t *)NULL) >= tend) {
+				stopped = 1;
+				break;
+			}
+			by = y/s2;
+			for (x = (y%s2 ? 0 : s); x < hres; x += y%s2 ? s : s2) {
+				i = y*hres + x;
+				bx = x/s2;
+				if (!busy[by*nbx+bx] &&
+					!(!(x%s2) && bx > 0 && busy[by*nbx+bx-1]) &&
+					!(!(y%s2) && by > 0 && busy[(by-1)*nbx+bx])) {
+							/* interpolate */
+					x0 = bx*s2; y0 = by*s2;
+					x1 = x0+s2 < hres ? x0+s2 : x0;
+					y1 = y0+s2 < vres ? y0+s2 : y0;
+					wx = (double)(x-x0)/s2;
+					wy = (double)(y-y0)/s2;
+					setcolor(pcol[i], 0., 0., 0.);
+					pz[i] = 0.;
+#define	 addcorner(xc,yc,wt)	w = wt; \
+					copycolor(ctmp, pcol[(yc)*hres+(xc)]); \
+					scalecolor(ctmp, w); \
+					addcolor(pcol[i], ctmp); \
+					pz[i] += w*pz[(yc)*hres+(xc)]
+					addcorner(x0, y0, (1.-wx)*(1.-wy));
+					addcorner(x1, y0, wx*(1.-wy));
+					addcorner(x0, y1, (1.-wx)*wy);
+					addcorner(x1, y1, wx*wy);
+#undef	 addcorner
+				} else
+					pz[i] = pixvalue(pcol[i], x, y);
+				plev[i] = s;
+			}
+		}
+		if (!stopped)
+			pctdone += 100./npasses;
+	}
+	free(busy);
+	free(plev);
+	free(pz);
+	free(pcol);
+	return(0);
+memerr:
+	error(SYSTEM, "out of memory in progressive");
+	return(-1);	/* pro forma return */
+}
+
+
+static int
+blockdiff(		/* check if block corners differ significantly */
+	COLOR	*pcol,
+	float	*pz,
+	int  x0,
+	int  y0,
+	int  x1,
+	int  y1
+)
+{
+	static const int  edge[4][4] = {{0,0,1,0}, {0,0,0,1},
+					{1,0,1,1}, {0,1,1,1}};
+	int  i, j, k;
+	double	z0, z1;
+
+	for (k = 4; k--; ) {
+		i = (edge[k][1] ? y1 : y0)*hres + (edge[k][0] ? x1 : x0);
+		j = (edge[k][3] ? y1 : y0)*hres + (edge[k][2] ? x1 : x0);
+		z0 = pz[i]; z1 = pz[j];
+		if (2.*fabs(z0-z1) > maxdiff*(z0+z1) ||
+				bigdiff(pcol[i], pcol[j], maxdiff))
+			return(1);
+	}
+	return(0);
+}
+
+
+static int
+progwrite(		/* write out current progressive picture */
+	COLOR	*pcol,
+	float	*pz,
+	unsigned char	*plev,
+	int  step,
+	int  final,
+	COLOR	*scanline,
+	float	*zline,
+	long  hdrend,
+	int  zfd
+)
+{
+	int  x, y, s, i;
+					/* only final pass to a pipe */
+	if ((hdrend < 0) & !final)
+		return(0);
+	if (hdrend >= 0 && fseek(stdout, hdrend, SEEK_SET) < 0)
+		return(-1);
+	if (zfd != -1 && lseek(zfd, (off_t)0, SEEK_SET) < 0)
+		return(-1);
+	for (y = vres; y--; ) {
+		for (x = 0; x < hres; x++) {
+			for (s = step; ; s <<= 1) {	/* nearest settled */
+				i = (y - y%s)*hres + (x - x%s);
+				if (plev[i])
+					break;
+			}
+			copycolor(scanline[x], pcol[i]);
+			if (zline != NULL)
+				zline[x] = pz[i];
+		}
+		if (directvis)			/* add bitty sources */
+			drawsources(&scanline, &zline, 0, hres, y, 1);
+		if (fwritescan(scanline, hres, stdout) < 0)
+			return(-1);
+		if (zfd != -1 && write(zfd, (char *)zline, hres*sizeof(float))
+				< hres*sizeof(float))
+			return(-1);
+	}
+	if (fflush(stdout) == EOF)
+		return(-1);
+	if (hdrend >= 0 && ftruncate(fileno(stdout), (off_t)ftell(stdout)) < 0)
+		return(-1);
+	return(0);
+}
+
+
+#ifdef ACCELERAD
+double
+#else
 static double
+#endif
 pixvalue(		/* compute pixel value */
 	COLOR  col,			/* returned color */
 	int  x,			/* pixel position */
@@ -733,7 +1218,17 @@ pixvalue(		/* compute pixel value */
 	RAY  thisray;
 	FVECT	lorg, ldir;
 	double	hpos, vpos, vdist, lmax;
+	unsigned	h;
 	int	i;
+						/* reset random state */
+	h = pixseed + (unsigned)y*hres + x;
+	h = (h ^ h>>16) * 0x45d9f3b;
+	h = (h ^ h>>16) * 0x45d9f3b;
+	h ^= h>>16;
+	srandom((long)(h & 0x7fffffff));
+	raynum = h >> 1;			/* unique ray numbers */
+	if (sizeof(RNUMBER) > 4)
+		raynum += ((RNUMBER)y*hres + x + 1) << 16 << 16;
 						/* compute view ray */
 	setcolor(col, 0.0, 0.0, 0.0);
 	hpos = (x+pixjitter())/hres;
@@ -42,6 +42,10 @@ extern void printRayTracingTime(const clock_t clock);
 
 extern int  ralrm;			/* seconds between reports */
 
+extern int  nproc;			/* number of rendering processes */
+
+extern int  progtime;			/* progressive time budget (sec.) */
+
 extern VIEW  ourview;			/* viewing parameters */
 
 extern int  hresolu;			/* horizontal resolution */
@@ -170,6 +174,16 @@ main(int  argc, char  *argv[])
 				goto badopt;
 			}
 			break;
+		case 'n':				/* number of cores */
+			check(2,"i");
+			nproc = atoi(argv[++i]);
+			if (nproc <= 0)
+				error(USER, "bad number of processes");
+			break;
+		case 'T':				/* time budget */
+			check(2,"i");
+			progtime = atoi(argv[++i]);
+			break;
 		case 'x':				/* x resolution */
 			check(2,"i");
 			hresolu = atoi(argv[++i]);
@@ -236,11 +250,32 @@ main(int  argc, char  *argv[])
 	err = setview(&ourview);	/* set viewing parameters */
 	if (err != NULL)
 		error(USER, err);
+	if (nproc > 1) {
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
+		if (use_optix) /* Don't allow multiple processes to access the graphics card. */
+			error(USER, "multiprocessing incompatible with GPU implementation");
+#endif
+		if (persist)
+			error(USER, "multiprocessing incompatible with persist file");
+	}
+	if (progtime > 0) {
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
+		if (use_optix)
+			error(USER, "progressive mode incompatible with GPU implementation");
+#elif defined(ACCELERAD)
+		use_optix = 0;	/* refine passes the usual way */
+#endif
+		if (nproc > 1)
+			error(USER, "progressive mode incompatible with multiprocessing");
+		if (recover != NULL)
+			error(USER, "progressive mode incompatible with recover file");
+	}
 					/* initialize object types */
 	initotypes();
 					/* initialize urand */
 	if (rand_samp) {
 		srandom((long)time(0));
+		rayseed();
 		initurand(0);
 	} else {
 		srandom(0L);
@@ -311,12 +346,17 @@ main(int  argc, char  *argv[])
 	          
 	ray_init_pmap();     /* PMAP: set up & load photon maps */
 
-#ifdef ACCELERAD
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
 	if (!use_optix) /* Don't shoot rays here, since the OptiX program should handle this. */
 #endif
 	marksources();			/* find and mark sources */
 
 	setambient();			/* initialize ambient calculation */
+
+	if (nproc > 1) {		/* share memory with children */
+		preload_objs();
+		shm_boundary = strcpy((char *)malloc(16), "SHM_BOUNDARY");
+	}
 	
 #ifdef  PERSIST
 	if (persist) {
@@ -334,6 +374,7 @@ main(int  argc, char  *argv[])
 				pfhold();
 				tstart = time((time_t *)NULL);
 				ambsync();		/* load new values */
+				RS_INIT();		/* own statistics */
 			}
 			if (rval < 0)
 				error(SYSTEM, "cannot fork child for persist function");
@@ -375,6 +416,7 @@ runagain:
 		pfhold();
 		tstart = time((time_t *)NULL);	/* reinitialize */
 		raynum = nrays = 0;
+		RS_INIT();		/* statistics for this run */
 		goto runagain;
 	}
 #endif
@@ -490,7 +532,9 @@ printdefaults(void)			/* print default values to stdout */
 	printf("-pd %f\t\t\t# pixel depth-of-field\n", dblur);
 	printf("-ps %-9d\t\t\t# pixel sample\n", psample);
 	printf("-pt %f\t\t\t# pixel threshold\n", maxdiff);
+	printf("-n  %-9d\t\t\t# number of rendering processes\n", nproc);
 	printf("-t  %-9d\t\t\t# time between reports\n", ralrm);
+	printf("-T  %-9d\t\t\t# progressive time budget\n", progtime);
 	printf(erract[WARNING].pf != NULL ?
 			"-w+\t\t\t\t# warning messages on\n" :
 			"-w-\t\t\t\t# warning messages off\n");
@@ -329,7 +329,7 @@ main(int  argc, char  *argv[])
 		}
 	}
 	if (nproc > 1) {
-#ifdef ACCELERAD
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
 		if (use_optix) /* Don't allow multiple processes to access the graphics card. */
 			error(USER, "multiprocessing incompatible with GPU implementation");
 #endif
@@ -345,6 +345,7 @@ main(int  argc, char  *argv[])
 					/* initialize urand */
 	if (rand_samp) {
 		srandom((long)time(0));
+		rayseed();
 		initurand(0);
 	} else {
 		srandom(0L);
@@ -419,7 +420,7 @@ main(int  argc, char  *argv[])
 	
 	ray_init_pmap();     /* PMAP: set up & load photon maps */
 	
-#ifdef ACCELERAD
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
 	if (!use_optix) /* Don't shoot rays here, since the OptiX program should handle this. */
 #endif
 	marksources();			/* find and mark sources */
@@ -440,6 +441,7 @@ main(int  argc, char  *argv[])
 				pflock(1);
 				pfhold();
 				ambsync();		/* load new values */
+				RS_INIT();		/* own statistics */
 			}
 			if (rval < 0)
 				error(SYSTEM, "cannot fork child for persist function");
@@ -478,6 +480,7 @@ runagain:
 	if (persist == PCHILD) {	/* wait for a signal then go again */
 		pfhold();
 		raynum = nrays = 0;		/* reinitialize */
+		RS_INIT();			/* statistics for this run */
 		goto runagain;
 	}
 #endif
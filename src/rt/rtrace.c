@@ -59,7 +59,7 @@ static void daysimOutput(RAY* r);
 static RAY  thisray;			/* for our convenience */
 
 typedef void putf_t(RREAL *v, int n);
-static putf_t puta, putd, putf, putrgbe;
+static putf_t puta, putd, putf, putrgbe, putdpack, putfpack;
 
 typedef void oputf_t(RAY *r);
 static oputf_t  oputo, oputd, oputv, oputV, oputl, oputL, oputc, oputp,
@@ -67,6 +67,8 @@ static oputf_t  oputo, oputd, oputv, oputV, oputl, oputL, oputc, oputp,
 		oputw, oputW, oputm, oputM, oputtilde;
 
 static void setoutput(char *vs);
+static int numonly(oputf_t **tp);
+static void flushpack(void);
 extern void tranotify(OBJECT obj);
 static void bogusray(void);
 static void raycast(RAY *r);
@@ -74,17 +76,33 @@ static void rayirrad(RAY *r);
 static void rtcompute(FVECT org, FVECT dir, double dmax);
 static int printvals(RAY *r);
 static int getvec(FVECT vec, int fmt, FILE *fp);
+static int getorgdir(FVECT org, FVECT dir, int fmt, FILE *fp);
 static void tabin(RAY *r);
 static void ourtrace(RAY *r);
 
 static oputf_t *ray_out[32], *every_out[32];
 static putf_t *putreal;
 
+#ifndef OPACKSIZ
+#define OPACKSIZ	256		/* values per packed binary write */
+#endif
+static union {
+	float	f[OPACKSIZ];
+	double	d[OPACKSIZ];
+}  opack;				/* packed binary output record */
+static int  npacked = 0;		/* values in opack */
+
 #ifdef ACCELERAD
 #define EXPECTED_RAY_COUNT	32
 
+#ifndef RTBATCH
+#define RTBATCH		65536		/* streamed rays per CPU batch */
+#endif
+
 /* from optix_rtrace.c */
 extern void computeOptix(const size_t width, const size_t height, const unsigned int imm_irrad, RAY* rays);
+
+static void tracebatch(RAY *rays, const size_t width, const size_t height);
 #endif
 
 
@@ -139,6 +157,10 @@ rtrace(				/* trace rays from file */
 #ifdef ACCELERAD
 	size_t current_ray, total_rays;
 	RAY* ray_cache;
+	const int  streaming = !vcount;	/* no fixed batch size? */
+#ifdef ACCELERAD_CPU
+	int  flushbatch = 0;		/* trace batch for flush interval? */
+#endif
 #endif
 					/* set up input */
 	if (fname == NULL)
@@ -170,6 +192,10 @@ rtrace(				/* trace rays from file */
 	default:
 		error(CONSISTENCY, "botched output format");
 	}
+					/* write records in one go? */
+	if (((outform == 'f') | (outform == 'd')) &&
+			numonly(ray_out) && numonly(every_out))
+		putreal = (outform == 'f') ? putfpack : putdpack;
 #ifdef ACCELERAD
 	if (use_optix) {
 		/* Populate the set of rays to trace */
@@ -191,8 +217,7 @@ rtrace(				/* trace rays from file */
 			fflush(stdout);
 	}
 					/* process file */
-	while (getvec(orig, inform, fp) == 0 &&
-			getvec(direc, inform, fp) == 0) {
+	while (getorgdir(orig, direc, inform, fp) == 0) {
 
 		d = normalize(direc);
 		if (d == 0.0) {				/* flush request? */
@@ -205,7 +230,9 @@ rtrace(				/* trace rays from file */
 				if (ray_pnprocs > 1 && ray_fifo_flush() < 0)
 					error(USER, "child(ren) died");
 				bogusray();
+				RS_BEGIN(iotime);
 				fflush(stdout);
+				RS_END(iotime);
 				nextflush = (!vresolu | (hresolu <= 1)) * hresolu;
 				something2flush = 0;
 			} else
@@ -231,13 +258,18 @@ rtrace(				/* trace rays from file */
 			rtcompute(orig, direc, lim_dist ? d : 0.0);
 #endif
 							/* flush if time */
-#ifdef ACCELERAD
+#if defined(ACCELERAD) && !defined(ACCELERAD_CPU)
 			if (!use_optix)
 #endif
 			if (!--nextflush) {
+#ifdef ACCELERAD_CPU
+				flushbatch = use_optix;	/* trace queue first */
+#endif
 				if (ray_pnprocs > 1 && ray_fifo_flush() < 0)
 					error(USER, "child(ren) died");
+				RS_BEGIN(iotime);
 				fflush(stdout);
+				RS_END(iotime);
 				nextflush = hresolu;
 			} else
 				something2flush = 1;
@@ -252,6 +284,21 @@ rtrace(				/* trace rays from file */
 					error(SYSTEM, "out of memory in rtrace");
 			}
 			ray_cache[current_ray++] = thisray;
+#ifdef ACCELERAD_CPU
+			/* No need to hold a stream until EOF on the CPU */
+			if (d == 0.0)
+				nextflush = (!vresolu | (hresolu <= 1)) * hresolu;
+			if (streaming && (flushbatch | (current_ray >= RTBATCH) ||
+					d == 0.0)) {
+				tracebatch(ray_cache, 1, current_ray);
+				current_ray = 0u;
+				RS_BEGIN(iotime);
+				if (fflush(stdout) < 0)
+					error(SYSTEM, "write error");
+				RS_END(iotime);
+				flushbatch = 0;
+			}
+#endif
 		} else /* Nothing ready to write yet. */
 #endif
 		if (ferror(stdout))
@@ -261,15 +308,11 @@ rtrace(				/* trace rays from file */
 	}
 #ifdef ACCELERAD
 	if (use_optix) {
-		/* Run OptiX kernel. */
-		total_rays = current_ray;
-		computeOptix(hresolu ? hresolu : 1, vresolu ? vresolu : total_rays, imm_irrad, ray_cache);
-
-		/* Write output */
-		for ( current_ray = 0u; current_ray < total_rays; ) {
-			printvals(&ray_cache[current_ray++]);
-		}
-
+		/* Run OptiX kernel and write output. */
+		if (streaming)
+			tracebatch(ray_cache, 1, current_ray);
+		else
+			tracebatch(ray_cache, hresolu ? hresolu : 1, vresolu ? vresolu : current_ray);
 		free(ray_cache);
 	} else /* OptiX kernel can only be launched from a single thread. */
 #endif
@@ -287,6 +330,26 @@ rtrace(				/* trace rays from file */
 }
 
 
+#ifdef ACCELERAD
+static void
+tracebatch(			/* trace and print a batch of rays */
+	RAY  *rays,
+	const size_t  width,
+	const size_t  height
+)
+{
+	const size_t  n = width * height;
+	size_t  i;
+
+	if (!n)
+		return;
+	computeOptix(width, height, imm_irrad, rays);
+	for (i = 0; i < n; i++)
+		printvals(&rays[i]);
+}
+#endif
+
+
 static void
 trace_sources(void)			/* trace rays to light sources, also */
 {
@@ -413,14 +476,29 @@ setoutput(				/* set up output tables */
 }
 
 
+static int
+numonly(			/* check output table for numbers only */
+	oputf_t **tp
+)
+{
+	for ( ; *tp != NULL; tp++)
+		if ((*tp == oputs) | (*tp == oputm) | (*tp == oputM) |
+				(*tp == oputtilde))
+			return(0);	/* written straight to stdout */
+	return(1);
+}
+
+
 static void
 bogusray(void)			/* print out empty record */
 {
+	rayorigin(&thisray, PRIMARY, NULL, NULL);
 #ifdef ACCELERAD
-	if (use_optix)
+	if (use_optix) {	/* null direction marks it for the batch */
+		thisray.rdir[0] = thisray.rdir[1] = thisray.rdir[2] = 0.0;
 		return; /* The rest will occur after the OptiX kernel runs. */
+	}
 #endif
-	rayorigin(&thisray, PRIMARY, NULL, NULL);
 	printvals(&thisray);
 }
 
@@ -467,8 +545,10 @@ rtcompute(			/* compute and print ray value(s) */
 	double	dmax
 )
 {
+	static RNUMBER	nrayin = 0;
 					/* set up ray */
 	rayorigin(&thisray, PRIMARY, NULL, NULL);
+	thisray.rkey = raystream(++nrayin);	/* follows input order */
 	if (imm_irrad) {
 		VSUM(thisray.rorg, org, dir, 1.1e-4);
 		thisray.rdir[0] = -dir[0];
@@ -484,8 +564,10 @@ rtcompute(			/* compute and print ray value(s) */
 			thisray.revf = raycast;
 	}
 #ifdef ACCELERAD
-	if (use_optix)
+	if (use_optix) {
+		thisray.rno = nrayin;	/* input index, however batched */
 		return; /* The rest will occur after the OptiX kernel runs. */
+	}
 #endif
 	if (ray_pnprocs > 1) {		/* multiprocessing FIFO? */
 		if (ray_fifo_in(&thisray) < 0)
@@ -511,6 +593,8 @@ printvals(			/* print requested ray values */
 		(**tp)(r);
 	if (outform == 'a')
 		putchar('\n');
+	else if (npacked)
+		flushpack();
 	return(1);
 }
 
@@ -553,6 +637,44 @@ getvec(		/* get a vector from fp */
 }
 
 
+static int
+getorgdir(		/* get ray origin and direction from fp */
+	FVECT  org,
+	FVECT  dir,
+	int  fmt,
+	FILE  *fp
+)
+{
+	static float  vf[6];
+	static double  vd[6];
+	int  rv = -1;
+
+	RS_BEGIN(iotime);
+	switch (fmt) {
+	case 'f':				/* whole record at once */
+		if (getbinary(vf, sizeof(float), 6, fp) != 6)
+			break;
+		VCOPY(org, vf);
+		VCOPY(dir, vf+3);
+		rv = 0;
+		break;
+	case 'd':
+		if (getbinary(vd, sizeof(double), 6, fp) != 6)
+			break;
+		VCOPY(org, vd);
+		VCOPY(dir, vd+3);
+		rv = 0;
+		break;
+	default:
+		if (getvec(org, fmt, fp) == 0)
+			rv = getvec(dir, fmt, fp);
+		break;
+	}
+	RS_END(iotime);
+	return(rv);
+}
+
+
 void
 tranotify(			/* record new modifier */
 	OBJECT	obj
@@ -601,6 +723,8 @@ ourtrace(				/* print ray values */
 		(**tp)(r);
 	if (outform == 'a')
 		putchar('\n');
+	else if (npacked)
+		flushpack();
 }
 
 
@@ -920,6 +1044,39 @@ putf(RREAL *v, int n)		/* output binary float(s) */
 }
 
 
+static void
+putdpack(RREAL *v, int n)	/* add binary double(s) to record */
+{
+	if (npacked + n > OPACKSIZ)
+		flushpack();
+	while (n-- > 0)
+		opack.d[npacked++] = *v++;
+}
+
+
+static void
+putfpack(RREAL *v, int n)	/* add binary float(s) to record */
+{
+	if (npacked + n > OPACKSIZ)
+		flushpack();
+	while (n-- > 0)
+		opack.f[npacked++] = *v++;
+}
+
+
+static void
+flushpack(void)			/* write out packed record */
+{
+	RS_BEGIN(iotime);
+	if (outform == 'f')
+		putbinary(opack.f, sizeof(float), npacked, stdout);
+	else
+		putbinary(opack.d, sizeof(double), npacked, stdout);
+	RS_END(iotime);
+	npacked = 0;
+}
+
+
 static void
 putrgbe(RREAL *v, int n)	/* output RGBE color */
 {
@@ -549,12 +549,12 @@ srcscatter(			/* compute source scattering into ray */
 		nsamps = MAXSSAMP;
 #endif
 	oldsampndx = samplendx;
-	samplendx = random()&0x7fff;		/* randomize */
+	samplendx = (int)(rayrand(r)*0x8000);	/* randomize */
 	for (i = volumePhotonMapping ? 1 : r->slights[0]; i > 0; i--) {
 		/* for each source OR once if volume photon map enabled */
 		for (j = 0; j < nsamps; j++) {	/* for each sample position */
 			samplendx++;
-			t = r->rot * (j+frandom())/nsamps;
+			t = r->rot * (j+rayrand(r))/nsamps;
 							/* extinction */
 			re = t*colval(r->cext,RED);
 			ge = t*colval(r->cext,GRN);
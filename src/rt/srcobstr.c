@@ -324,14 +324,19 @@ srcblocked(RAY *r)
 
 	if (obs == OVOID)
 		return(0);
+	RS_COUNT(sbtests);
 	op = objptr(obs);		/* check blocker intersection */
 	if (!(*ofun[op->otype].funp)(op, r))
 		return(0);
-	if (source[r->rsrc].sflags & SDISTANT)
+	if (source[r->rsrc].sflags & SDISTANT) {
+		RS_COUNT(sbhits);
 		return(1);
+	}
 	op = source[r->rsrc].so;	/* check source intersection */
-	if (!(*ofun[op->otype].funp)(op, r))
+	if (!(*ofun[op->otype].funp)(op, r)) {
+		RS_COUNT(sbhits);
 		return(1);
+	}
 	rayclear(r);
 	return(0);			/* source in front */
 }
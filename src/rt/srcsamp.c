@@ -70,12 +70,12 @@ nextsample:
 	if (dstrsrc > FTINY) {			/* jitter sample */
 		dimlist[ndims] = si->sn + 8831;
 		dimlist[ndims+1] = si->sp + 3109;
-		d = urand(ilhash(dimlist,ndims+2)+samplendx);
+		d = rayurand(r, ilhash(dimlist,ndims+2)+samplendx);
 		if (srcp->sflags & SFLAT) {
-			multisamp(vpos, 2, d);
+			raymultisamp(vpos, 2, d, r);
 			vpos[SW] = 0.5;
 		} else
-			multisamp(vpos, 3, d);
+			raymultisamp(vpos, 3, d, r);
 		for (i = 0; i < 3; i++)
 			vpos[i] = dstrsrc * (1. - 2.*vpos[i]) *
 					(double)size[i]*(1.0/MAXSPART);
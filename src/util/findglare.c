@@ -22,6 +22,7 @@ VIEW	leftview, rightview;		/* leftmost and rightmost views */
 
 char	*picture = NULL;		/* picture file name */
 char	*octree = NULL;			/* octree file name */
+char	*viewseq = NULL;		/* view sequence file name */
 
 int	verbose = 0;			/* verbose reporting */
 char	*progname;			/* global argv[0] */
@@ -41,6 +42,10 @@ long	npixmiss;			/* number of pixels missed */
 
 static int angcmp(const void *ap1, const void *ap2);
 static void init(void);
+static void initview(void);
+static int nextview(VIEW *vp, FILE *fp);
+static void findsources(VIEW *vp, double thresh, int combine,
+		int argc, char *argv[]);
 static void cleanup(void);
 static void printsources(void);
 static void printillum(void);
@@ -55,6 +60,9 @@ main(
 {
 	int	combine = 1;
 	int	gotview = 0;
+	VIEW	seqview;
+	FILE	*seqfp = NULL;
+	double	thresh;
 	int	rval, i;
 	char	*err;
 
@@ -115,6 +123,9 @@ main(
 		case 'p':
 			picture = argv[++i];
 			break;
+		case 'S':
+			viewseq = argv[++i];
+			break;
 		case 'c':
 			combine = !combine;
 			break;
@@ -189,25 +200,13 @@ main(
 		}
 	}
 	if (!gotview) {
-		if (picture == NULL) {
+		if (picture == NULL && viewseq == NULL) {
 			fprintf(stderr, "%s: must have view or picture\n",
 					progname);
 			exit(1);
 		}
-		ourview = pictview;
-	} else if (picture != NULL && !VEQ(ourview.vp, pictview.vp)) {
-		fprintf(stderr, "%s: picture must have same viewpoint\n",
-				progname);
-		exit(1);
-	}
-	ourview.type = VT_HEM;
-	ourview.horiz = ourview.vert = 180.0;
-	ourview.hoff = ourview.voff = 0.0;
-	fvsum(ourview.vdir, ourview.vdir, ourview.vup,
-			-DOT(ourview.vdir,ourview.vup));
-	if ((err = setview(&ourview)) != NULL) {
-		fprintf(stderr, "%s: %s\n", progname, err);
-		exit(1);
+		if (picture != NULL)
+			ourview = pictview;
 	}
 	if (octree == NULL && picture == NULL) {
 		fprintf(stderr,
@@ -215,27 +214,31 @@ main(
 				progname);
 		exit(1);
 	}
+	if (viewseq != NULL && (seqfp = fopen(viewseq, "r")) == NULL) {
+		fprintf(stderr, "%s: cannot open view file \"%s\"\n",
+				progname, viewseq);
+		exit(1);
+	}
 	init();					/* initialize program */
-	if (threshold <= FTINY)
-		comp_thresh();			/* compute glare threshold */
-	analyze();				/* analyze view */
-	if (combine)
-		absorb_specks();		/* eliminate tiny sources */
+	thresh = threshold;			/* 0 means compute per view */
+	if (viewseq == NULL)			/* analyze view */
+		findsources(&ourview, thresh, combine, argc, argv);
+	else {					/* or each in sequence */
+		seqview = ourview;
+		for (i = 0; nextview(&seqview, seqfp) != EOF; i++)
+			findsources(&seqview, thresh, combine, argc, argv);
+		fclose(seqfp);
+		if (!i) {
+			fprintf(stderr, "%s: no views in file \"%s\"\n",
+					progname, viewseq);
+			exit(1);
+		}
+	}
 	cleanup();				/* tidy up */
-						/* print header */
-	newheader("RADIANCE", stdout);
-	printargs(argc, argv, stdout);
-	fputs(VIEWSTR, stdout);
-	fprintview(&ourview, stdout);
-	printf("\n");
-	fputformat("ascii", stdout);
-	printf("\n");
-	printsources();				/* print glare sources */
-	printillum();				/* print illuminances */
 	exit(0);
 userr:
 	fprintf(stderr,
-"Usage: %s [view options][-ga angles][-p picture][[rtrace options] octree]\n",
+"Usage: %s [view options][-S vfile][-ga angles][-p picture][[rtrace options] octree]\n",
 			progname);
 	exit(1);
 }
@@ -291,13 +294,6 @@ init(void)				/* initialize global variables */
 	indirect = (struct illum *)calloc(nglardirs, sizeof(struct illum));
 	if (indirect == NULL)
 		memerr("indirect illuminances");
-	npixinvw = npixmiss = 0L;
-	leftview = ourview;
-	rightview = ourview;
-	spinvector(leftview.vdir, ourview.vdir, ourview.vup, maxtheta);
-	spinvector(rightview.vdir, ourview.vdir, ourview.vup, -maxtheta);
-	setview(&leftview);
-	setview(&rightview);
 	indirect[nglarangs].lcos =
 	indirect[nglarangs].rcos = cos(maxtheta);
 	indirect[nglarangs].rsin =
@@ -337,6 +333,88 @@ init(void)				/* initialize global variables */
 }
 
 
+static void
+initview(void)				/* initialize for new view */
+{
+	int	i;
+
+	for (i = 0; i < nglardirs; i++)
+		indirect[i].sum = indirect[i].n = 0.0;
+	npixinvw = npixmiss = 0L;
+	leftview = ourview;
+	rightview = ourview;
+	spinvector(leftview.vdir, ourview.vdir, ourview.vup, maxtheta);
+	spinvector(rightview.vdir, ourview.vdir, ourview.vup, -maxtheta);
+	setview(&leftview);
+	setview(&rightview);
+}
+
+
+static int
+nextview(			/* get next view from fp */
+	VIEW	*vp,
+	FILE	*fp
+)
+{
+	char	linebuf[256];
+
+	while (fgets(linebuf, sizeof(linebuf), fp) != NULL)
+		if (isview(linebuf) && sscanview(vp, linebuf) > 0)
+			return(0);
+	return(EOF);
+}
+
+
+static void
+findsources(			/* find and print glare sources for view */
+	VIEW	*vp,
+	double	thresh,
+	int	combine,
+	int	argc,
+	char	*argv[]
+)
+{
+	char	*err;
+
+	if (picture != NULL && !VEQ(vp->vp, pictview.vp)) {
+		fprintf(stderr, "%s: picture must have same viewpoint\n",
+				progname);
+		exit(1);
+	}
+	ourview = *vp;
+	ourview.type = VT_HEM;
+	ourview.horiz = ourview.vert = 180.0;
+	ourview.hoff = ourview.voff = 0.0;
+	fvsum(ourview.vdir, ourview.vdir, ourview.vup,
+			-DOT(ourview.vdir,ourview.vup));
+	if ((err = setview(&ourview)) != NULL) {
+		fprintf(stderr, "%s: %s\n", progname, err);
+		exit(1);
+	}
+	initview();
+	if ((threshold = thresh) <= FTINY)
+		comp_thresh();			/* compute glare threshold */
+	analyze();				/* analyze view */
+	if (combine)
+		absorb_specks();		/* eliminate tiny sources */
+	if (npixinvw < 100*npixmiss)
+		fprintf(stderr, "%s: warning -- missing %d%% of samples\n",
+				progname, (int)(100L*npixmiss/npixinvw));
+						/* print header */
+	newheader("RADIANCE", stdout);
+	printargs(argc, argv, stdout);
+	fputs(VIEWSTR, stdout);
+	fprintview(&ourview, stdout);
+	printf("\n");
+	fputformat("ascii", stdout);
+	printf("\n");
+	printsources();				/* print glare sources */
+	printillum();				/* print illuminances */
+	free_sources();
+	fflush(stdout);
+}
+
+
 static void
 cleanup(void)				/* close files, wait for children */
 {
@@ -346,9 +424,6 @@ cleanup(void)				/* close files, wait for children */
 		close_pict();
 	if (octree != NULL)
 		done_rtrace();
-	if (npixinvw < 100*npixmiss)
-		fprintf(stderr, "%s: warning -- missing %d%% of samples\n",
-				progname, (int)(100L*npixmiss/npixinvw));
 }
 
 
@@ -85,12 +85,13 @@ extern double pixsize(int x, int y);
 extern void comp_thresh(void);
 extern void analyze(void);
 extern void absorb_specks(void);
+extern void free_sources(void);
 	/* defined in glareval.c */
 extern void open_pict(char *fn);
 extern void fork_rtrace(char *av[]);
 extern void close_pict(void);
 extern void done_rtrace(void);
-extern void getviewspan(int vv, float *vb);
+extern void getviewspan(int vv, int hstep, float *vb);
 extern double getviewpix(int vh, int vv);
 
 #ifdef __cplusplus
@@ -20,6 +20,7 @@ static const char	RCSid[] = "$Id: glarendx.c,v 2.15 2020/02/17 19:35:24 greg Exp
  */
 
 #include <string.h>
+#include <ctype.h>
 
 #include "standard.h"
 #include "view.h"
@@ -53,6 +54,8 @@ static gdfun total;
 static gethfunc headline;
 static void init(void);
 static void read_input(void);
+static int more_input(void);
+static void free_input(void);
 static void print_values(gdfun *func);
 static double posindex(FVECT sd, FVECT vd, FVECT vu);
 
@@ -122,13 +125,16 @@ main(
 					/* find and run calculation */
 	for (funp = all_funcs; funp->name != NULL; funp++)
 		if (!strcmp(funp->name, progtail)) {
-			init();
-			read_input();
-			if (print_header) {
-				printargs(i, argv, stdout);
-				putchar('\n');
-			}
-			print_values(funp->func);
+			do {		/* one record per view */
+				init();
+				read_input();
+				if (print_header) {
+					printargs(i, argv, stdout);
+					putchar('\n');
+				}
+				print_values(funp->func);
+				free_input();
+			} while (more_input());
 			exit(0);		/* we're done */
 		}
 					/* invalid function */
@@ -193,6 +199,7 @@ read_input(void)			/* read glare sources from stdin */
 #define S_SOURCE	1
 #define S_DIREC		2
 	int	state = S_SEARCH;
+	int	nsect = 0;
 	char	buf[128];
 	struct glare_src	*gs;
 	struct glare_dir	*gd;
@@ -207,6 +214,8 @@ read_input(void)			/* read glare sources from stdin */
 			break;
 		case S_SOURCE:
 			if (!strncmp(buf, "END", 3)) {
+				if (++nsect == 2)
+					return;	/* end of record */
 				state = S_SEARCH;
 				break;
 			}
@@ -223,6 +232,8 @@ read_input(void)			/* read glare sources from stdin */
 			break;
 		case S_DIREC:
 			if (!strncmp(buf, "END", 3)) {
+				if (++nsect == 2)
+					return;	/* end of record */
 				state = S_SEARCH;
 				break;
 			}
@@ -249,6 +260,37 @@ readerr:
 }
 
 
+static int
+more_input(void)			/* check for another record */
+{
+	int	c;
+
+	while ((c = getchar()) != EOF && isspace(c))
+		;
+	if (c == EOF)
+		return(0);
+	ungetc(c, stdin);
+	return(1);
+}
+
+
+static void
+free_input(void)			/* free sources and directions */
+{
+	struct glare_src	*gs;
+	struct glare_dir	*gd;
+
+	while ((gs = all_srcs) != NULL) {
+		all_srcs = gs->next;
+		free((void *)gs);
+	}
+	while ((gd = all_dirs) != NULL) {
+		all_dirs = gd->next;
+		free((void *)gd);
+	}
+}
+
+
 static void
 print_values(		/* print out calculations */
 	gdfun *func
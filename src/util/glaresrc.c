@@ -74,7 +74,7 @@ analyze(void)			/* analyze our scene */
 			fflush(stderr);
 		}
 #endif
-		getviewspan(v, spanbr);
+		getviewspan(v, 1, spanbr);
 		left = hsize + 1;
 		for (h = -hsize; h <= hsize; h++) {
 			if (spanbr[h+hsize] < 0.0) {	/* off view */
@@ -159,21 +159,27 @@ comp_thresh(void)			/* compute glare threshold */
 {
 	int	h, v;
 	int	nsamps;
-	double	brsum, br;
+	double	brsum;
+	float	*spanbr;
 
 	if (verbose)
 		fprintf(stderr, "%s: computing glare threshold...\n",
 				progname);
+	spanbr = (float *)malloc((2*hsize+1)*sizeof(float));
+	if (spanbr == NULL)
+		memerr("view span brightness buffer");
 	brsum = 0.0;
 	nsamps = 0;
 	for (v = vsize; v >= -vsize; v -= TSAMPSTEP) {
+		getviewspan(v, TSAMPSTEP, spanbr);	/* one batch per row */
 		for (h = -hsize; h <= hsize; h += TSAMPSTEP) {
-			if ((br = getviewpix(h, v)) < 0.0)
+			if (spanbr[h+hsize] < 0.0)
 				continue;
-			brsum += br;
+			brsum += spanbr[h+hsize];
 			nsamps++;
 		}
 	}
+	free((void *)spanbr);
 	if (nsamps == 0) {
 		fprintf(stderr, "%s: no viewable scene!\n", progname);
 		exit(1);
@@ -502,6 +508,19 @@ absorb(			/* absorb a source into indirect */
 }
 
 
+extern void
+free_sources(void)			/* free finished sources */
+{
+	struct source	*sp;
+
+	while ((sp = donelist) != NULL) {
+		donelist = sp->next;
+		freespans(sp);
+		free((void *)sp);
+	}
+}
+
+
 static void
 freespans(			/* free spans associated with source */
 	struct source	*sp
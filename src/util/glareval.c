@@ -215,8 +215,9 @@ getviewpix(		/* compute single view pixel */
 
 
 extern void
-getviewspan(		/* compute a span of view pixels */
+getviewspan(		/* compute every hstep'th view pixel in span */
 	int	vv,
+	int	hstep,
 	float	*vb
 )
 {
@@ -233,6 +234,10 @@ getviewspan(		/* compute a span of view pixels */
 #endif
 	n = 0;
 	for (vh = -hsize; vh <= hsize; vh++) {
+		if ((vh+hsize) % hstep) {		/* not wanted */
+			vb[vh+hsize] = -1.0;
+			continue;
+		}
 		if (compdir(dir, vh, vv) < 0) {		/* not in view */
 			vb[vh+hsize] = -1.0;
 			continue;
@@ -13,6 +13,8 @@ static const char RCSid[] = "$Id: rcollate.c,v 2.35 2019/12/28 18:05:14 greg Exp
 #if defined(_WIN32) || defined(_WIN64)
   #undef ftello
   #define	ftello	ftell
+  #undef fseeko
+  #define	fseeko	fseek
   #undef ssize_t
   #define ssize_t	size_t
 #else
@@ -21,6 +23,15 @@ static const char RCSid[] = "$Id: rcollate.c,v 2.35 2019/12/28 18:05:14 greg Exp
 
 #define MAXLEVELS	16	/* max RxC.. block pairs */
 
+#define TILESIZ		16	/* leaf size for recursive transpose */
+
+#ifndef MAXBLKMEM
+#define MAXBLKMEM	(1L<<25)	/* bytes per transpose buffer */
+#endif
+#ifndef MAXINMEM
+#define MAXINMEM	(1L<<30)	/* larger binary transposes use a file */
+#endif
+
 typedef struct {
 	void	*mapped;	/* memory-mapped pointer */
 	void	*base;		/* pointer to base memory */
@@ -397,6 +408,178 @@ get_input_pos(int r, int c)
 	return(n);
 }
 
+/* transpose nr x nc records from src into dst, halving the longer side */
+static void
+transpose_block(char *dst, size_t dstride, const char *src, size_t sstride,
+		int nr, int nc, int rsiz)
+{
+	int	i, j;
+
+	while ((nr > TILESIZ) | (nc > TILESIZ))
+		if (nr >= nc) {
+			int	h = nr>>1;
+			transpose_block(dst, dstride, src, sstride, h, nc, rsiz);
+			dst += (size_t)h*rsiz;
+			src += (size_t)h*sstride;
+			nr -= h;
+		} else {
+			int	h = nc>>1;
+			transpose_block(dst, dstride, src, sstride, nr, h, rsiz);
+			dst += (size_t)h*dstride;
+			src += (size_t)h*rsiz;
+			nc -= h;
+		}
+	for (i = 0; i < nr; i++)
+		for (j = 0; j < nc; j++)
+			memcpy(dst + j*dstride + (size_t)i*rsiz,
+					src + i*sstride + (size_t)j*rsiz, rsiz);
+}
+
+/* output transposed binary data from memory, a band of rows at a time */
+static int
+transpose_binary(const char *base)
+{
+	const int	rsiz = n_comp*comp_size;
+	const size_t	orow = (size_t)no_columns*rsiz;
+	long		nb = MAXBLKMEM/orow;
+	char		*obuf;
+	int		i;
+
+	if (nb < 1)
+		nb = 1;
+	if (nb > no_rows)
+		nb = no_rows;
+	if ((obuf = (char *)malloc(nb*orow)) == NULL) {
+		fputs("Out of memory in transpose_binary()\n", stderr);
+		return(0);
+	}
+	for (i = 0; i < no_rows; i += nb) {
+		if (nb > no_rows-i)
+			nb = no_rows-i;
+		transpose_block(obuf, orow, base + (size_t)i*rsiz,
+				(size_t)ni_columns*rsiz, ni_rows, nb, rsiz);
+		if (fwrite(obuf, orow, nb, stdout) != nb) {
+			fputs("Error writing to stdout\n", stderr);
+			free(obuf);
+			return(0);
+		}
+	}
+	free(obuf);
+	return(1);
+}
+
+/* output reordered binary data from memory, a row at a time */
+static int
+reorder_binary(const char *base, long nrecords)
+{
+	const int	rsiz = n_comp*comp_size;
+	char		*obuf = (char *)malloc((size_t)no_columns*rsiz);
+	int		i, j;
+
+	if (obuf == NULL) {
+		fputs("Out of memory in reorder_binary()\n", stderr);
+		return(0);
+	}
+	for (i = 0; i < no_rows; i++) {
+		for (j = 0; j < no_columns; j++) {
+			long	n = get_input_pos(i, j);
+			if (n >= nrecords) {
+				fputs("Index past end-of-file\n", stderr);
+				free(obuf);
+				return(0);
+			}
+			memcpy(obuf + (size_t)j*rsiz, base + (size_t)n*rsiz, rsiz);
+		}
+		if (fwrite(obuf, rsiz, no_columns, stdout) != no_columns) {
+			fputs("Error writing to stdout\n", stderr);
+			free(obuf);
+			return(0);
+		}
+	}
+	free(obuf);
+	return(1);
+}
+
+/*
+ * Transpose binary input too large to hold in memory.  The first pass
+ * reads blocks of input rows and writes each block transposed to a
+ * temporary file; the second pass gathers bands of output rows from
+ * every block.  Each pass reads its data once, in large pieces.
+ */
+static int
+transpose_external(FILE *fp)
+{
+	const int	rsiz = n_comp*comp_size;
+	const size_t	irow = (size_t)ni_columns*rsiz;
+	const size_t	orow = (size_t)ni_rows*rsiz;
+	long		nr = MAXBLKMEM/irow;
+	long		nb = MAXBLKMEM/orow;
+	char		*ibuf = NULL, *tbuf = NULL, *obuf = NULL;
+	FILE		*tfp;
+	long		r, n;
+	int		i, b, ok = 0;
+
+	if (nr < 1)
+		nr = 1;
+	if (nr > ni_rows)
+		nr = ni_rows;
+	if (nb < 1)
+		nb = 1;
+	if (nb > ni_columns)
+		nb = ni_columns;
+	if ((tfp = tmpfile()) == NULL) {
+		fputs("Cannot create temporary file for transpose\n", stderr);
+		return(0);
+	}
+	ibuf = (char *)malloc(nr*irow);
+	tbuf = (char *)malloc(nr*irow > nb*nr*rsiz ? nr*irow : nb*nr*rsiz);
+	obuf = (char *)malloc(nb*orow);
+	if ((ibuf == NULL) | (tbuf == NULL) | (obuf == NULL)) {
+		fputs("Out of memory in transpose_external()\n", stderr);
+		goto cleanup;
+	}
+	for (r = 0; r < ni_rows; r += nr) {	/* transpose row blocks */
+		n = (nr < ni_rows-r) ? nr : ni_rows-r;
+		if (fread(ibuf, irow, n, fp) != n) {
+			fputs("Unexpected EOF on input\n", stderr);
+			goto cleanup;
+		}
+		transpose_block(tbuf, n*rsiz, ibuf, irow, n, ni_columns, rsiz);
+		if (fwrite(tbuf, irow, n, tfp) != n) {
+			fputs("Error writing temporary file\n", stderr);
+			goto cleanup;
+		}
+	}
+	free(ibuf); ibuf = NULL;
+	for (i = 0; i < ni_columns; i += nb) {	/* gather output bands */
+		if (nb > ni_columns-i)
+			nb = ni_columns-i;
+		for (r = 0; r < ni_rows; r += nr) {
+			n = (nr < ni_rows-r) ? nr : ni_rows-r;
+			if (fseeko(tfp, (off_t)r*irow + (off_t)i*n*rsiz,
+					SEEK_SET) < 0 ||
+					fread(tbuf, n*rsiz, nb, tfp) != nb) {
+				fputs("Error reading temporary file\n", stderr);
+				goto cleanup;
+			}
+			for (b = 0; b < nb; b++)
+				memcpy(obuf + b*orow + r*rsiz,
+						tbuf + b*n*rsiz, n*rsiz);
+		}
+		if (fwrite(obuf, orow, nb, stdout) != nb) {
+			fputs("Error writing to stdout\n", stderr);
+			goto cleanup;
+		}
+	}
+	ok = 1;
+cleanup:
+	if (ibuf) free(ibuf);
+	if (tbuf) free(tbuf);
+	if (obuf) free(obuf);
+	fclose(tfp);
+	return(ok);
+}
+
 /* output reordered ASCII or binary data from memory */
 static int
 do_reorder(const MEMLOAD *mp)
@@ -452,7 +635,11 @@ do_reorder(const MEMLOAD *mp)
 				stderr);
 		return(0);
 	}
-						/* reorder records */
+	if (rp == NULL)				/* binary output */
+		return((transpose & (outLevels <= 1)) ?
+				transpose_binary((const char *)mp->base) :
+				reorder_binary((const char *)mp->base, nrecords));
+						/* reorder ASCII records */
 	for (i = 0; i < no_rows; i++) {
 	    for (j = 0; j < no_columns; j++) {
 		long	n = get_input_pos(i, j);
@@ -460,21 +647,15 @@ do_reorder(const MEMLOAD *mp)
 			fputs("Index past end-of-file\n", stderr);
 			return(0);
 		}
-		if (rp != NULL) {		/* ASCII output */
-			print_record(rp, n);
-			putc(tabEOL[j >= no_columns-1], stdout);
-		} else {			/* binary output */
-			putbinary((char *)mp->base + (n_comp*comp_size)*n,
-					comp_size, n_comp, stdout);
-		}
+		print_record(rp, n);
+		putc(tabEOL[j >= no_columns-1], stdout);
 	    }
 	    if (ferror(stdout)) {
 		fprintf(stderr, "Error writing to stdout\n");
 		return(0);
 	    }
 	}
-	if (rp != NULL)
-		free_records(rp);
+	free_records(rp);
 	return(1);
 badspec:
 	fprintf(stderr, "Bad dimension(s)\n");
@@ -717,7 +898,13 @@ main(int argc, char *argv[])
 		fputformat(fmtid, stdout);
 		fputc('\n', stdout);		/* finish new header */
 	}
-	if (transpose | (outLevels > 1)) {	/* moving stuff around? */
+	if (transpose & (outLevels <= 1) && comp_size &&
+			(ni_rows > 0) & (ni_columns > 0) &&
+			(no_rows == ni_columns) & (no_columns == ni_rows) &&
+			(double)ni_rows*ni_columns*n_comp*comp_size > MAXINMEM) {
+		if (!transpose_external(stdin))	/* too big for memory */
+			return(1);
+	} else if (transpose | (outLevels > 1)) {	/* moving stuff around? */
 		MEMLOAD	myMem;			/* need to map into memory */
 		if (a == argc-1) {
 			if (load_file(&myMem, stdin) <= 0) {
@@ -1183,7 +1183,7 @@ load_scene(const char *inspec, int (*ocb)(FILE *))
 	int	rv = 0;
 	char	inpbuf[1024];
 	FILE	*fp;
-	int	c;
+	int	c, first;
 
 	if (*inspec == '!')
 		fp = popen(inspec+1, "r");
@@ -1193,7 +1193,8 @@ load_scene(const char *inspec, int (*ocb)(FILE *))
 		fprintf(stderr, "%s: cannot load '%s'\n", progname, inspec);
 		return(-1);
 	}
-	while ((c = getc(fp)) != EOF) {	/* load receiver data */
+					/* load receiver data */
+	for (first = 1; (c = getc(fp)) != EOF; first = 0) {
 		if (isspace(c))		/* skip leading white space */
 			continue;
 		if (c == '!') {		/* read from a new command */
@@ -1208,6 +1209,12 @@ load_scene(const char *inspec, int (*ocb)(FILE *))
 		if (c == '#') {		/* parameters/comment */
 			if ((c = getc(fp)) == EOF || ungetc(c,fp) == EOF)
 				break;
+			if ((c == '?') & first) {
+				fprintf(stderr,
+			"%s: '%s' is not a text scene - use \"rad2bin -r\"\n",
+						progname, inspec);
+				return(-1);
+			}
 			if (!isspace(c) && fscanf(fp, "%s", inpbuf) == 1 &&
 					!strcmp(inpbuf, PARAMSTART)) {
 				if (fgets(inpbuf, sizeof(inpbuf), fp) != NULL)
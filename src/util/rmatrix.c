@@ -163,7 +163,7 @@ rmx_load_double(RMATRIX *rm, FILE *fp)
 {
 	int	i;
 
-	if ((char *)&rmx_lval(rm,0,0,0) - (char *)&rmx_lval(rm,1,0,0) !=
+	if ((char *)&rmx_lval(rm,1,0,0) - (char *)&rmx_lval(rm,0,0,0) !=
 					sizeof(double)*rm->ncols*rm->ncomp) {
 		fputs("Code error in rmx_load_double()\n", stderr);
 		exit(1);
@@ -201,124 +201,154 @@ rmx_load_rgbe(RMATRIX *rm, FILE *fp)
 	return(1);
 }
 
-/* Load matrix from supported file type */
-RMATRIX *
-rmx_load(const char *inspec)
+/* Check for XML (BSDF) file specification */
+static int
+is_xml(const char *inspec)
 {
-	FILE		*fp = stdin;
-	RMATRIX		dinfo;
-	RMATRIX		*dnew;
+	const char	*sp = inspec;		/* check suffix */
+
+	if (!inspec || inspec[0] == '!')
+		return(0);
+	while (*sp)
+		++sp;
+	while (sp > inspec && sp[-1] != '.')
+		--sp;
+	return(!strcasecmp(sp, "XML"));
+}
+
+/* Open matrix stream and load header (NULL for stdin, '!' with command) */
+FILE *
+rmx_open(const char *inspec, RMATRIX *rminfo)
+{
+	FILE	*fp = stdin;
 
 	if (!inspec) {				/* reading from stdin? */
-		inspec = "<stdin>";
 		SET_FILE_BINARY(stdin);
 	} else if (inspec[0] == '!') {
 		if (!(fp = popen(inspec+1, "r")))
 			return(NULL);
 		SET_FILE_BINARY(fp);
-	} else {
-		const char	*sp = inspec;	/* check suffix */
-		while (*sp)
-			++sp;
-		while (sp > inspec && sp[-1] != '.')
-			--sp;
-		if (!strcasecmp(sp, "XML")) {	/* assume it's a BSDF */
-			CMATRIX	*cm = cm_loadBTDF((char *)inspec);
-			if (!cm)
-				return(NULL);
-			dnew = rmx_from_cmatrix(cm);
-			cm_free(cm);
-			dnew->dtype = DTascii;
-			return(dnew);
-		}
-						/* else open it ourselves */
-		if (!(fp = fopen(inspec, "rb")))
-			return(NULL);
-	}
+	} else if (is_xml(inspec) || !(fp = fopen(inspec, "rb")))
+		return(NULL);
 #ifdef getc_unlocked
 	flockfile(fp);
 #endif
-	dinfo.nrows = dinfo.ncols = dinfo.ncomp = 0;
-	dinfo.dtype = DTascii;			/* assumed w/o FORMAT */
-	dinfo.swapin = 0;
-	dinfo.info = NULL;
-	dinfo.mtx[0] = dinfo.mtx[1] = dinfo.mtx[2] = 1.;
-	if (getheader(fp, get_dminfo, &dinfo) < 0) {
-		fclose(fp);
-		return(NULL);
-	}
-	if ((dinfo.nrows <= 0) | (dinfo.ncols <= 0)) {
-		if (!fscnresolu(&dinfo.ncols, &dinfo.nrows, fp)) {
-			fclose(fp);
-			return(NULL);
-		}
-		if (dinfo.ncomp <= 0)
-			dinfo.ncomp = 3;
-		else if ((dinfo.dtype == DTrgbe) | (dinfo.dtype == DTxyze) &&
-				dinfo.ncomp != 3) {
-			fclose(fp);
-			return(NULL);
-		}
+	rminfo->nrows = rminfo->ncols = rminfo->ncomp = 0;
+	rminfo->dtype = DTascii;		/* assumed w/o FORMAT */
+	rminfo->swapin = 0;
+	rminfo->info = NULL;
+	rminfo->mtx[0] = rminfo->mtx[1] = rminfo->mtx[2] = 1.;
+	if (getheader(fp, get_dminfo, rminfo) < 0)
+		goto openerr;
+	if ((rminfo->nrows <= 0) | (rminfo->ncols <= 0)) {
+		if (!fscnresolu(&rminfo->ncols, &rminfo->nrows, fp))
+			goto openerr;
+		if (rminfo->ncomp <= 0)
+			rminfo->ncomp = 3;
+		else if ((rminfo->dtype == DTrgbe) | (rminfo->dtype == DTxyze) &&
+				rminfo->ncomp != 3)
+			goto openerr;
 	}
-	dnew = rmx_alloc(dinfo.nrows, dinfo.ncols, dinfo.ncomp);
-	if (!dnew) {
-		fclose(fp);
-		return(NULL);
-	}
-	dnew->info = dinfo.info;
-	switch (dinfo.dtype) {
+	return(fp);
+openerr:
+	rmx_close(inspec, fp);
+	if (rminfo->info)
+		free(rminfo->info);
+	rminfo->info = NULL;
+	return(NULL);
+}
+
+/* Load the next rm->nrows rows from a stream opened with rmx_open() */
+int
+rmx_load_data(RMATRIX *rm, const RMATRIX *rminfo, FILE *fp)
+{
+	double	sf[3];
+
+	if (!rm | !rminfo | !fp || (rm->ncols != rminfo->ncols) |
+				(rm->ncomp != rminfo->ncomp))
+		return(0);
+	rm->swapin = rminfo->swapin;
+	switch (rminfo->dtype) {
 	case DTascii:
 		SET_FILE_TEXT(fp);
-		if (!rmx_load_ascii(dnew, fp))
-			goto loaderr;
-		dnew->dtype = DTascii;		/* should leave double? */
+		if (!rmx_load_ascii(rm, fp))
+			return(0);
 		break;
 	case DTfloat:
-		dnew->swapin = dinfo.swapin;
-		if (!rmx_load_float(dnew, fp))
-			goto loaderr;
-		dnew->dtype = DTfloat;
+		if (!rmx_load_float(rm, fp))
+			return(0);
 		break;
 	case DTdouble:
-		dnew->swapin = dinfo.swapin;
-		if (!rmx_load_double(dnew, fp))
-			goto loaderr;
-		dnew->dtype = DTdouble;
+		if (!rmx_load_double(rm, fp))
+			return(0);
 		break;
 	case DTrgbe:
 	case DTxyze:
-		if (!rmx_load_rgbe(dnew, fp))
-			goto loaderr;
-		dnew->dtype = dinfo.dtype;	/* undo exposure? */
-		if ((dinfo.mtx[0] != 1.) | (dinfo.mtx[1] != 1.) |
-				(dinfo.mtx[2] != 1.)) {
-			dinfo.mtx[0] = 1./dinfo.mtx[0];
-			dinfo.mtx[1] = 1./dinfo.mtx[1];
-			dinfo.mtx[2] = 1./dinfo.mtx[2];
-			rmx_scale(dnew, dinfo.mtx);
+		if (!rmx_load_rgbe(rm, fp))
+			return(0);
+		if ((rminfo->mtx[0] != 1.) | (rminfo->mtx[1] != 1.) |
+				(rminfo->mtx[2] != 1.)) {
+			sf[0] = 1./rminfo->mtx[0];	/* undo exposure */
+			sf[1] = 1./rminfo->mtx[1];
+			sf[2] = 1./rminfo->mtx[2];
+			rmx_scale(rm, sf);
 		}
 		break;
 	default:
-		goto loaderr;
-	}
-	if (fp != stdin) {
-		if (inspec[0] == '!')
-			pclose(fp);
-		else
-			fclose(fp);
+		return(0);
 	}
+	rm->dtype = rminfo->dtype;		/* should leave double? */
+	return(1);
+}
+
+/* Close a stream opened with rmx_open() */
+void
+rmx_close(const char *inspec, FILE *fp)
+{
+	if (fp == stdin) {
 #ifdef getc_unlocked
-	else
 		funlockfile(fp);
 #endif
-	return(dnew);
-loaderr:					/* should report error? */
-	if (inspec[0] == '!')
+	} else if (inspec[0] == '!')
 		pclose(fp);
 	else
 		fclose(fp);
-	rmx_free(dnew);
-	return(NULL);
+}
+
+/* Load matrix from supported file type */
+RMATRIX *
+rmx_load(const char *inspec)
+{
+	FILE		*fp;
+	RMATRIX		dinfo;
+	RMATRIX		*dnew;
+
+	if (is_xml(inspec)) {			/* assume it's a BSDF */
+		CMATRIX	*cm = cm_loadBTDF((char *)inspec);
+		if (!cm)
+			return(NULL);
+		dnew = rmx_from_cmatrix(cm);
+		cm_free(cm);
+		dnew->dtype = DTascii;
+		return(dnew);
+	}
+	if (!(fp = rmx_open(inspec, &dinfo)))
+		return(NULL);
+	dnew = rmx_alloc(dinfo.nrows, dinfo.ncols, dinfo.ncomp);
+	if (!dnew) {
+		rmx_close(inspec, fp);
+		if (dinfo.info)
+			free(dinfo.info);
+		return(NULL);
+	}
+	dnew->info = dinfo.info;
+	if (!rmx_load_data(dnew, &dinfo, fp)) {
+		rmx_close(inspec, fp);		/* should report error? */
+		rmx_free(dnew);
+		return(NULL);
+	}
+	rmx_close(inspec, fp);
+	return(dnew);
 }
 
 static int
@@ -394,32 +424,49 @@ rmx_write_rgbe(const RMATRIX *rm, FILE *fp)
 	return(1);
 }
 
-/* Write matrix to file type indicated by dtype */
+/* Write matrix header for the given type, returning type used (0 on error) */
 int
-rmx_write(const RMATRIX *rm, int dtype, FILE *fp)
+rmx_write_header(const RMATRIX *rm, int dtype, FILE *fp)
 {
-	RMATRIX	*mydm = NULL;
-	int	ok = 1;
-
 	if (!rm | !fp)
 		return(0);
-#ifdef getc_unlocked
-	flockfile(fp);
-#endif
-						/* complete header */
-	if (rm->info)
-		fputs(rm->info, fp);
 	if (dtype == DTfromHeader)
 		dtype = rm->dtype;
 	else if ((dtype == DTrgbe) & (rm->dtype == DTxyze))
 		dtype = DTxyze;
 	else if ((dtype == DTxyze) & (rm->dtype == DTrgbe))
 		dtype = DTrgbe;
+	if ((dtype <= DTfromHeader) | (dtype >= DTend))
+		return(0);
+	if ((dtype == DTrgbe) | (dtype == DTxyze) &&
+			(rm->ncomp != 3) & (rm->ncomp != 1))
+		return(0);			/* only convert grayscale */
+	if (rm->info)				/* complete header */
+		fputs(rm->info, fp);
 	if ((dtype != DTrgbe) & (dtype != DTxyze)) {
 		fprintf(fp, "NROWS=%d\n", rm->nrows);
 		fprintf(fp, "NCOLS=%d\n", rm->ncols);
 		fprintf(fp, "NCOMP=%d\n", rm->ncomp);
-	} else if (rm->ncomp != 3) {		/* wrong # components? */
+	}
+	if ((dtype == DTfloat) | (dtype == DTdouble))
+		fputendian(fp);			/* important to record */
+	fputformat((char *)cm_fmt_id[dtype], fp);
+	fputc('\n', fp);
+	if ((dtype == DTrgbe) | (dtype == DTxyze))
+		fprtresolu(rm->ncols, rm->nrows, fp);
+	return(dtype);
+}
+
+/* Write matrix rows following header for type from rmx_write_header() */
+int
+rmx_write_data(const RMATRIX *rm, int dtype, FILE *fp)
+{
+	RMATRIX	*mydm = NULL;
+	int	ok;
+
+	if (!rm | !fp)
+		return(0);
+	if ((dtype == DTrgbe) | (dtype == DTxyze) && rm->ncomp != 3) {
 		double	cmtx[3];
 		if (rm->ncomp != 1)		/* only convert grayscale */
 			return(0);
@@ -429,10 +476,6 @@ rmx_write(const RMATRIX *rm, int dtype, FILE *fp)
 			return(0);
 		rm = mydm;
 	}
-	if ((dtype == DTfloat) | (dtype == DTdouble))
-		fputendian(fp);			/* important to record */
-	fputformat((char *)cm_fmt_id[dtype], fp);
-	fputc('\n', fp);
 	switch (dtype) {			/* write data */
 	case DTascii:
 		ok = rmx_write_ascii(rm, fp);
@@ -445,18 +488,34 @@ rmx_write(const RMATRIX *rm, int dtype, FILE *fp)
 		break;
 	case DTrgbe:
 	case DTxyze:
-		fprtresolu(rm->ncols, rm->nrows, fp);
 		ok = rmx_write_rgbe(rm, fp);
 		break;
 	default:
-		return(0);
+		ok = 0;
+		break;
 	}
+	if (mydm)
+		rmx_free(mydm);
+	return(ok);
+}
+
+/* Write matrix to file type indicated by dtype */
+int
+rmx_write(const RMATRIX *rm, int dtype, FILE *fp)
+{
+	int	ok;
+
+	if (!rm | !fp)
+		return(0);
+#ifdef getc_unlocked
+	flockfile(fp);
+#endif
+	ok = (dtype = rmx_write_header(rm, dtype, fp)) &&
+			rmx_write_data(rm, dtype, fp);
 	ok &= (fflush(fp) == 0);
 #ifdef getc_unlocked
 	funlockfile(fp);
 #endif
-	if (mydm)
-		rmx_free(mydm);
 	return(ok);
 }
 
@@ -36,12 +36,27 @@ extern int	rmx_newtype(int dtyp1, int dtyp2);
 /* Load matrix from supported file type (NULL for stdin, '!' with command) */
 extern RMATRIX	*rmx_load(const char *inspec);
 
+/* Open matrix stream and load header (NULL for stdin, '!' with command) */
+extern FILE	*rmx_open(const char *inspec, RMATRIX *rminfo);
+
+/* Load the next rm->nrows rows from a stream opened with rmx_open() */
+extern int	rmx_load_data(RMATRIX *rm, const RMATRIX *rminfo, FILE *fp);
+
+/* Close a stream opened with rmx_open() */
+extern void	rmx_close(const char *inspec, FILE *fp);
+
 /* Append header information associated with matrix data */
 extern int	rmx_addinfo(RMATRIX *rm, const char *info);
 
 /* Write matrix to file type indicated by dtype */
 extern int	rmx_write(const RMATRIX *rm, int dtype, FILE *fp);
 
+/* Write matrix header for the given type, returning type used (0 on error) */
+extern int	rmx_write_header(const RMATRIX *rm, int dtype, FILE *fp);
+
+/* Write matrix rows following header for type from rmx_write_header() */
+extern int	rmx_write_data(const RMATRIX *rm, int dtype, FILE *fp);
+
 /* Allocate and assign square identity matrix with n components */
 extern RMATRIX	*rmx_identity(int dim, int n);
 
@@ -14,6 +14,10 @@ static const char RCSid[] = "$Id: rmtxop.c,v 2.17 2019/12/28 18:05:14 greg Exp $
 
 #define MAXCOMP		16		/* #components we support */
 
+#ifndef MAXBLOCKMEM
+#define MAXBLOCKMEM	(64L<<20)	/* target bytes per streamed row block */
+#endif
+
 static const char	stdin_name[] = "<stdin>";
 
 /* unary matrix operation(s) */
@@ -52,6 +56,29 @@ loadmatrix(ROPMAT *rop)
 	return(1);
 }
 
+/* Check and expand scalar factors for operand with n components */
+static int
+get_scalars(ROPMAT *rop, int n)
+{
+	int	i;
+
+	if (rop->preop.nsf <= 0)
+		return(1);
+	if (rop->preop.clen > 0) {
+		fputs("Options -s and -c are exclusive\n", stderr);
+		return(0);
+	}
+	if (rop->preop.nsf == 1) {
+		for (i = n; --i > 0; )
+			rop->preop.sca[i] = rop->preop.sca[0];
+	} else if (rop->preop.nsf != n) {
+		fprintf(stderr, "%s: -s must have one or %d factors\n",
+				rop->inspec, n);
+		return(0);
+	}
+	return(1);
+}
+
 /* Get matrix and perform unary operations */
 static RMATRIX *
 loadop(ROPMAT *rop)
@@ -63,18 +90,8 @@ loadop(ROPMAT *rop)
 		return(NULL);
 
 	if (rop->preop.nsf > 0) {		/* apply scalar(s) */
-		if (rop->preop.clen > 0) {
-			fputs("Options -s and -c are exclusive\n", stderr);
-			goto failure;
-		}
-		if (rop->preop.nsf == 1) {
-			for (i = rop->mtx->ncomp; --i; )
-				rop->preop.sca[i] = rop->preop.sca[0];
-		} else if (rop->preop.nsf != rop->mtx->ncomp) {
-			fprintf(stderr, "%s: -s must have one or %d factors\n",
-					rop->inspec, rop->mtx->ncomp);
+		if (!get_scalars(rop, rop->mtx->ncomp))
 			goto failure;
-		}
 		if (!rmx_scale(rop->mtx, rop->preop.sca)) {
 			fputs(rop->inspec, stderr);
 			fputs(": scalar operation failed\n", stderr);
@@ -280,6 +297,268 @@ prefer_right2left(ROPMAT *mop)
 	return(t_ncols(mop+mri) < t_nrows(mop));
 }
 
+/* Apply component transform to a row block */
+static RMATRIX *
+block_transform(ROPMAT *rop, RMATRIX *mblk)
+{
+	RMATRIX	*mres;
+
+	if (rop->preop.clen % mblk->ncomp) {
+		fprintf(stderr, "%s: -c must have N x %d coefficients\n",
+				rop->inspec, mblk->ncomp);
+		return(NULL);
+	}
+	mres = rmx_transform(mblk, rop->preop.clen/mblk->ncomp,
+				rop->preop.cmat);
+	if (mres == NULL)
+		fprintf(stderr, "%s: matrix transform failed\n", rop->inspec);
+	return(mres);
+}
+
+/* Multiply operands i through j in the order given by split table */
+static RMATRIX *
+chain_product(RMATRIX **mat, int *split, int n, int i, int j)
+{
+	RMATRIX	*mleft, *mright, *mres;
+	int	k;
+
+	if (i == j) {
+		mres = mat[i];
+		mat[i] = NULL;
+		return(mres);
+	}
+	k = split[i*n + j];
+	mleft = chain_product(mat, split, n, i, k);
+	mright = chain_product(mat, split, n, k+1, j);
+	if ((mleft == NULL) | (mright == NULL))
+		mres = NULL;
+	else
+		mres = rmx_multiply(mleft, mright);
+	rmx_free(mleft);
+	rmx_free(mright);
+	return(mres);
+}
+
+/*
+ * Evaluate a chain of concatenations, streaming the leftmost matrix
+ * through the product in row blocks so it need never be held in memory.
+ * The right-hand operands are split into groups that are multiplied
+ * together once beforehand, chosen to minimize the total number of
+ * multiply-adds given the rows of the leftmost matrix.  Scalar factors
+ * on the leftmost matrix and the result are folded into the smallest
+ * operand.  Returns 1 on success, 0 on failure, or -1 if the chain
+ * cannot be streamed and should be evaluated in memory, which is only
+ * decided before any input has been read from a pipe.
+ */
+static int
+stream_chain(ROPMAT *mop, int nmats, int outfmt, int argc, char *argv[])
+{
+	const char	*inspec = mop[0].inspec == stdin_name ?
+					(const char *)NULL : mop[0].inspec;
+	ROPMAT		*trail = mop + nmats;
+	RMATRIX		minfo, hinfo;
+	RMATRIX		**mat, *mblk = NULL, *mres;
+	FILE		*fp;
+	double		*cost, *best, c;
+	int		*split, *gstart, *gend, *gfirst;
+	int		*dim, ncomp, ngroups;
+	long		nrows, r, brows, width;
+	int		i, j, k, len, ok = 0;
+
+	if (nmats < 2 || mop[0].preop.transpose | trail->preop.transpose)
+		return(-1);
+	for (i = 0; i < nmats-1; i++)
+		if (mop[i].binop != '.')
+			return(-1);
+	if ((fp = rmx_open(inspec, &minfo)) == NULL) {
+		if (inspec != NULL && inspec[0] != '!')
+			return(-1);	/* let in-memory load report it */
+		fputs(mop[0].inspec, stderr);	/* input already consumed */
+		fputs(": cannot load matrix\n", stderr);
+		return(0);
+	}
+	if (minfo.info)
+		free(minfo.info);
+	nrows = minfo.nrows;
+	ncomp = minfo.ncomp;
+	if (!get_scalars(mop, ncomp))
+		goto cleanup0;
+	if (mop[0].preop.clen > 0) {
+		if (mop[0].preop.clen % ncomp) {
+			fprintf(stderr, "%s: -c must have N x %d coefficients\n",
+					mop[0].inspec, ncomp);
+			goto cleanup0;
+		}
+		ncomp = mop[0].preop.clen / ncomp;
+	}
+	mat = (RMATRIX **)calloc(nmats, sizeof(RMATRIX *));
+	dim = (int *)malloc(nmats*sizeof(int));
+	cost = (double *)malloc(nmats*nmats*sizeof(double));
+	split = (int *)malloc(nmats*nmats*sizeof(int));
+	best = (double *)malloc(nmats*sizeof(double));
+	gstart = (int *)malloc(3*nmats*sizeof(int));
+	if ((mat == NULL) | (dim == NULL) | (cost == NULL) | (split == NULL) |
+			(best == NULL) | (gstart == NULL)) {
+		fputs("Out of memory in stream_chain()\n", stderr);
+		exit(1);
+	}
+	gend = gstart + nmats;
+	gfirst = gend + nmats;
+	dim[0] = minfo.ncols;		/* load right-hand operands */
+	for (i = 1; i < nmats; i++) {
+		if ((mat[i] = loadop(mop+i)) == NULL)
+			goto cleanup;
+		if (mat[i]->ncomp != ncomp) {
+			fputs(mop[i].inspec, stderr);
+			fputs(": # components do not match\n", stderr);
+			goto cleanup;
+		}
+		if (mat[i]->nrows != dim[i-1]) {
+			fputs(mop[i].inspec, stderr);
+			fputs(": mismatched dimensions\n", stderr);
+			goto cleanup;
+		}
+		dim[i] = mat[i]->ncols;
+	}
+	trail->inspec = "trailing_ops";
+	if (!get_scalars(trail, ncomp))
+		goto cleanup;
+	if (mop[0].preop.nsf > 0 || trail->preop.nsf > 0) {
+		double	sf[MAXCOMP];
+		for (k = ncomp; k--; )	/* fold scalars into smallest */
+			sf[k] = (mop[0].preop.nsf > 0 ? mop[0].preop.sca[k] : 1.) *
+				(trail->preop.nsf > 0 ? trail->preop.sca[k] : 1.);
+		j = 1;
+		for (i = 2; i < nmats; i++)
+			if ((double)dim[i-1]*dim[i] < (double)dim[j-1]*dim[j])
+				j = i;
+		rmx_scale(mat[j], sf);
+		if (verbose)
+			fprintf(stderr, "%s: applied fused scalar\n",
+					mop[j].inspec);
+	}
+				/* optimal order for each sub-chain i..j */
+	for (i = 1; i < nmats; i++)
+		cost[i*nmats + i] = 0;
+	for (len = 1; len < nmats-1; len++)
+		for (i = 1; i+len < nmats; i++) {
+			j = i + len;
+			cost[i*nmats + j] = -1;
+			for (k = i; k < j; k++) {
+				c = cost[i*nmats + k] + cost[(k+1)*nmats + j] +
+					(double)dim[i-1]*dim[k]*dim[j];
+				if ((cost[i*nmats + j] < 0) | (c < cost[i*nmats + j])) {
+					cost[i*nmats + j] = c;
+					split[i*nmats + j] = k;
+				}
+			}
+		}
+				/* best grouping for streamed rows */
+	best[0] = 0;
+	for (j = 1; j < nmats; j++) {
+		best[j] = -1;
+		for (i = 1; i <= j; i++) {
+			c = best[i-1] + cost[i*nmats + j] +
+				(double)nrows*dim[i-1]*dim[j];
+			if ((best[j] < 0) | (c < best[j])) {
+				best[j] = c;
+				gstart[j] = i;
+			}
+		}
+	}
+	ngroups = 0;		/* collect groups in reverse order */
+	for (j = nmats-1; j > 0; j = gstart[j]-1)
+		gend[ngroups++] = j;
+	for (i = 0; i < ngroups/2; i++) {
+		k = gend[i]; gend[i] = gend[ngroups-1-i]; gend[ngroups-1-i] = k;
+	}
+	width = dim[0];		/* premultiply each group */
+	for (i = 0; i < ngroups; i++) {
+		gfirst[i] = k = gstart[gend[i]];
+		if ((mat[k] = chain_product(mat, split, nmats,
+					k, gend[i])) == NULL) {
+			fputs(mop[gend[i]].inspec, stderr);
+			fputs(": concatenation failed\n", stderr);
+			goto cleanup;
+		}
+		if (dim[gend[i]] > width)
+			width = dim[gend[i]];
+		if (verbose && gend[i] > k)
+			fprintf(stderr, "%s: premultiplied %d matrices\n",
+					mop[gend[i]].inspec, gend[i]-k+1);
+	}
+	brows = MAXBLOCKMEM / (sizeof(double)*(minfo.ncomp + 2L*ncomp)*width);
+	if (brows < 1)
+		brows = 1;
+	if (brows > nrows)
+		brows = nrows;
+	if (verbose)
+		fprintf(stderr, "%s: streaming %ld rows in blocks of %ld\n",
+				mop[0].inspec, nrows, brows);
+	if ((mblk = rmx_alloc(brows, minfo.ncols, minfo.ncomp)) == NULL) {
+		fputs("Out of memory in stream_chain()\n", stderr);
+		exit(1);
+	}
+	for (r = 0; r < nrows; r += brows) {
+		mres = mblk;
+		mres->nrows = (nrows-r < brows) ? nrows-r : brows;
+		if (!rmx_load_data(mres, &minfo, fp)) {
+			fputs(mop[0].inspec, stderr);
+			fputs(": error reading matrix\n", stderr);
+			goto cleanup;
+		}
+		if (mop[0].preop.clen > 0 &&
+				(mres = block_transform(mop, mblk)) == NULL)
+			goto cleanup;
+		for (i = 0; i < ngroups; i++) {
+			RMATRIX	*mnext = rmx_multiply(mres, mat[gfirst[i]]);
+			if (mres != mblk)
+				rmx_free(mres);
+			if ((mres = mnext) == NULL) {
+				fputs(mop[gend[i]].inspec, stderr);
+				fputs(": concatenation failed\n", stderr);
+				goto cleanup;
+			}
+		}
+		if (trail->preop.clen > 0) {
+			RMATRIX	*mnext;
+			mnext = block_transform(trail, mres);
+			rmx_free(mres);
+			if ((mres = mnext) == NULL)
+				goto cleanup;
+		}
+		if (!r) {		/* header from first block */
+			if (outfmt == DTfromHeader)
+				outfmt = mres->dtype;
+			if (outfmt != DTascii)
+				SET_FILE_BINARY(stdout);
+			newheader("RADIANCE", stdout);
+			printargs(argc, argv, stdout);
+			hinfo = *mres;
+			hinfo.nrows = nrows;
+			outfmt = rmx_write_header(&hinfo, outfmt, stdout);
+		}
+		if (!outfmt || !rmx_write_data(mres, outfmt, stdout)) {
+			fprintf(stderr, "%s: error writing result matrix\n",
+					argv[0]);
+			rmx_free(mres);
+			goto cleanup;
+		}
+		rmx_free(mres);
+	}
+	ok = (fflush(stdout) == 0);
+	if (!ok)
+		fprintf(stderr, "%s: error writing result matrix\n", argv[0]);
+cleanup:
+	for (i = nmats; i--; )
+		rmx_free(mat[i]);
+	free(mat); free(dim); free(cost); free(split); free(best); free(gstart);
+	rmx_free(mblk);
+cleanup0:
+	rmx_close(inspec == NULL ? stdin_name : inspec, fp);
+	return(ok);
+}
+
 static int
 get_factors(double da[], int n, char *av[])
 {
@@ -399,6 +678,9 @@ main(int argc, char *argv[])
 				argv[0], mop[nmats-1].binop);
 		return(1);
 	}
+					/* stream long concatenations */
+	if ((i = stream_chain(mop, nmats, outfmt, argc, argv)) >= 0)
+		return(!i);
 					/* favor quicker concatenation */
 	mop[nmats].mtx = prefer_right2left(mop) ? op_right2left(mop)
 						: op_left2right(mop);
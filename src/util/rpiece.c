@@ -9,6 +9,7 @@ static const char	RCSid[] = "$Id: rpiece.c,v 2.58 2020/02/28 05:18:49 greg Exp $
 #include <stdio.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/time.h>
 
 #include "platform.h"
 #ifndef NON_POSIX /* XXX need abstraction for process management */
@@ -19,6 +20,7 @@ static const char	RCSid[] = "$Id: rpiece.c,v 2.58 2020/02/28 05:18:49 greg Exp $
 #include "color.h"
 #include "view.h"
 #include "rtprocess.h"
+#include "selcall.h"
 
 #ifndef F_SETLKW
 
@@ -49,6 +51,8 @@ main(
 #define  MAXFORK		0
 #endif
 #endif
+
+#define  MAXKIDS		128	/* maximum rpict processes with -n */
 					/* protection from SYSV signals(!) */
 #if defined(sgi)
 #define guard_io()	sighold(SIGALRM)
@@ -77,6 +81,7 @@ long  scanorig;
 FILE  *syncfp = NULL;		/* synchronization file pointer */
 int  synclst = F_UNLCK;		/* synchronization file lock status */
 int  nforked = 0;
+int  nkids = 0;			/* rpict processes in coordinator mode */
 
 #define  sflock(t)	if ((t)!=synclst) dolock(fileno(syncfp),synclst=t)
 
@@ -95,7 +100,10 @@ static int nextpiece(int	*xp, int	*yp);
 static int rvrpiece(int	*xp, int	*yp);
 static int cleanup(int  rstat);
 static void rpiece(void);
+static void getpiece(FILE *fp, int xpos, int ypos);
 static int putpiece(int	xpos, int	ypos);
+static void coordinate(VIEW *vp);
+static int bestpiece(double *ptime, char *pstat);
 static void filerr(char  *t);
 
 
@@ -184,6 +192,16 @@ main(
 					break;
 				vmult = atoi(argv[++i]);
 				continue;
+			case 'n':		/* coordinate n processes */
+				if (argv[i][2])
+					break;
+				nkids = atoi(argv[++i]);
+				if ((nkids <= 0) | (nkids > MAXKIDS)) {
+					fprintf(stderr, "%s: bad number of processes\n",
+							argv[0]);
+					exit(1);
+				}
+				continue;
 			case 'R':		/* recover */
 				if (argv[i][2])
 					break;
@@ -221,6 +239,10 @@ main(
 		fprintf(stderr, "%s: missing output file\n", argv[0]);
 		exit(1);
 	}
+	if (nkids && rvrlim >= 0) {
+		fprintf(stderr, "%s: -n incompatible with -R\n", argv[0]);
+		exit(1);
+	}
 	init(argc, argv);
 	rpiece();
 	exit(cleanup(0));
@@ -261,7 +283,7 @@ init(			/* set up output file and start rpict */
 		fprintf(stderr, "%s: %s\n", progname, err);
 		exit(1);
 	}
-	if (syncfp != NULL) {
+	if (syncfp != NULL && !nkids) {	/* coordinator only writes it */
 		sflock(F_RDLCK);
 		fscanf(syncfp, "%d %d", &hmult, &vmult);
 		sflock(F_UNLCK);
@@ -305,6 +327,10 @@ init(			/* set up output file and start rpict */
 		fputformat(COLRFMT, fp);
 		putc('\n', fp);
 		fprtresolu(hres*hmult, vres*vmult, fp);
+	} else if (nkids) {		/* we own the whole picture */
+		fprintf(stderr, "%s: output file \"%s\" already exists\n",
+				progname, outfile);
+		exit(1);
 	} else if ((outfd = open(outfile, O_RDWR)) >= 0) {
 		dolock(outfd, F_RDLCK);
 		if ((fp = fdopen(dup(outfd), "r+")) == NULL)
@@ -325,6 +351,15 @@ init(			/* set up output file and start rpict */
 	if (fclose(fp) == -1)		/* done with stream i/o */
 		goto filerr;
 	dolock(outfd, F_UNLCK);
+	if ((pbuf = (COLR *)bmalloc(hres*vres*sizeof(COLR))) == NULL) {
+		fprintf(stderr, "%s: out of memory\n", progname);
+		exit(1);
+	}
+	signal(SIGALRM, onalrm);
+	if (timelim)
+		alarm(timelim);
+	if (nkids)			/* coordinate() starts processes */
+		return;
 					/* start rpict process */
 	rpd = sp_inactive;
 	if (open_process(&rpd, rpargv) <= 0) {
@@ -337,13 +372,6 @@ init(			/* set up output file and start rpict */
 				progname, rpargv[0]);
 		exit(1);
 	}
-	if ((pbuf = (COLR *)bmalloc(hres*vres*sizeof(COLR))) == NULL) {
-		fprintf(stderr, "%s: out of memory\n", progname);
-		exit(1);
-	}
-	signal(SIGALRM, onalrm);
-	if (timelim)
-		alarm(timelim);
 	return;
 filerr:
 	fprintf(stderr, "%s: i/o error on file \"%s\"\n", progname, outfile);
@@ -449,8 +477,10 @@ cleanup(			/* close rpict process and clean up */
 	int  status;
 
 	bfree((char *)pbuf, hres*vres*sizeof(COLR));
-	fclose(torp);
-	fclose(fromrp);
+	if (torp != NULL)
+		fclose(torp);
+	if (fromrp != NULL)
+		fclose(fromrp);
 	while (wait(&status) != -1)
 		if (rstat == 0)
 			rstat = status>>8 & 0xff;
@@ -504,6 +534,10 @@ rpiece(void)			/* render picture piece by piece */
 		fprintf(stderr, "%s: unknown view type '-vt%c'\n",
 				progname, ourview.type);
 		exit(cleanup(1));
+	}
+	if (nkids) {			/* hand out pieces ourselves */
+		coordinate(&pview);
+		return;
 	}
 					/* render each piece */
 	while (nextpiece(&xorg, &yorg)) {
@@ -518,14 +552,13 @@ rpiece(void)			/* render picture piece by piece */
 }
 
 
-static int
-putpiece(		/* get next piece from rpict */
-int	xpos,
-int	ypos
+static void
+getpiece(		/* read next piece from rpict into pbuf */
+	FILE	*fp,
+	int	xpos,
+	int	ypos
 )
 {
-	struct flock  fls;
-	int  pid, status;
 	int  hr, vr;
 	int  y;
 				/* check bounds */
@@ -536,8 +569,8 @@ int	ypos
 	}
 				/* check header from rpict */
 	guard_io();
-	getheader(fromrp, NULL, NULL);
-	if (!fscnresolu(&hr, &vr, fromrp) || (hr != hres) | (vr != vres)) {
+	getheader(fp, NULL, NULL);
+	if (!fscnresolu(&hr, &vr, fp) || (hr != hres) | (vr != vres)) {
 		fprintf(stderr, "%s: resolution mismatch from %s\n",
 				progname, rpargv[0]);
 		exit(cleanup(1));
@@ -550,13 +583,28 @@ int	ypos
 				/* load new piece into buffer */
 	for (y = 0; y < vr; y++) {
 		guard_io();
-		if (freadcolrs(pbuf+y*hr, hr, fromrp) < 0) {
+		if (freadcolrs(pbuf+y*hr, hr, fp) < 0) {
 			fprintf(stderr, "%s: read error from %s\n",
 					progname, rpargv[0]);
 			exit(cleanup(1));
 		}
 		unguard();
 	}
+}
+
+
+static int
+putpiece(		/* get next piece from rpict */
+int	xpos,
+int	ypos
+)
+{
+	struct flock  fls;
+	int  pid, status;
+	int  hr = hres, vr = vres;
+	int  y;
+
+	getpiece(fromrp, xpos, ypos);
 #if MAXFORK
 				/* fork so we don't slow rpict down */
 	if ((pid = fork()) > 0) {
@@ -629,6 +677,192 @@ int	ypos
 }
 
 
+static int
+bestpiece(		/* pick remaining piece with highest estimated cost */
+	double	*ptime,
+	char	*pstat
+)
+{
+	double	tsum = 0, est, best = -1;
+	int	nt = 0, nn, ibest = -1;
+	int	x, y, i;
+					/* average time of finished pieces */
+	for (i = hmult*vmult; i--; )
+		if (pstat[i] == 2) {
+			tsum += ptime[i];
+			nt++;
+		}
+	/*
+	 * Rendering cost is spatially coherent, so we estimate a piece
+	 * by its finished neighbors, falling back on the overall mean.
+	 * Expensive regions thus go out early, and cheap pieces fill
+	 * in the tail where processes would otherwise sit idle.
+	 */
+	for (x = hmult; x--; )
+		for (y = vmult; y--; ) {
+			i = x*vmult + y;
+			if (pstat[i])
+				continue;
+			est = 0; nn = 0;
+			if (x > 0 && pstat[i-vmult] == 2) {
+				est += ptime[i-vmult]; nn++;
+			}
+			if (x < hmult-1 && pstat[i+vmult] == 2) {
+				est += ptime[i+vmult]; nn++;
+			}
+			if (y > 0 && pstat[i-1] == 2) {
+				est += ptime[i-1]; nn++;
+			}
+			if (y < vmult-1 && pstat[i+1] == 2) {
+				est += ptime[i+1]; nn++;
+			}
+			if (nn)
+				est /= (double)nn;
+			else if (nt)
+				est = tsum/nt;
+			if (est > best) {
+				best = est;
+				ibest = i;
+			}
+		}
+	return(ibest);
+}
+
+
+static void
+coordinate(		/* farm pieces out to our own rpict processes */
+	VIEW	*vp
+)
+{
+	SUBPROC	kidpr[MAXKIDS];
+	FILE	*kidto[MAXKIDS], *kidfrom[MAXKIDS];
+	int	kidpiece[MAXKIDS];
+	struct timeval	kidstart[MAXKIDS], tnow;
+	COLR	*picture, *pp;
+	double	*ptime;
+	char	*pstat;			/* 0 = waiting, 1 = busy, 2 = done */
+	fd_set	readset;
+	int	nbusy = 0, nfd, rstat;
+	int	i, k, x, y, j;
+
+	if ((picture = (COLR *)calloc((size_t)hres*hmult*vres*vmult,
+					sizeof(COLR))) == NULL ||
+			(ptime = (double *)malloc(hmult*vmult*sizeof(double)))
+					== NULL ||
+			(pstat = (char *)calloc(hmult*vmult, sizeof(char)))
+					== NULL) {
+		fprintf(stderr, "%s: out of memory\n", progname);
+		exit(cleanup(1));
+	}
+	if (nkids > hmult*vmult)
+		nkids = hmult*vmult;
+	for (k = 0; k < nkids; k++) {	/* start rpict processes */
+		kidpr[k] = sp_inactive;
+		if (open_process(&kidpr[k], rpargv) <= 0) {
+			fprintf(stderr, "%s: cannot start %s\n",
+					progname, rpargv[0]);
+			exit(cleanup(1));
+		}
+		if ((kidfrom[k] = fdopen(kidpr[k].r, "r")) == NULL ||
+				(kidto[k] = fdopen(kidpr[k].w, "w")) == NULL) {
+			fprintf(stderr, "%s: cannot open stream to %s\n",
+					progname, rpargv[0]);
+			exit(cleanup(1));
+		}
+		kidpiece[k] = -1;
+	}
+	for ( ; ; ) {			/* assign idle processes */
+		for (k = 0; k < nkids && !gotalrm; k++) {
+			if (kidpiece[k] >= 0)
+				continue;
+			if ((i = bestpiece(ptime, pstat)) < 0)
+				break;
+			x = i / vmult; y = i % vmult;
+			vp->hoff = ourview.hoff*hmult + x - 0.5*(hmult-1);
+			vp->voff = ourview.voff*vmult + y - 0.5*(vmult-1);
+			fputs(VIEWSTR, kidto[k]);
+			fprintview(vp, kidto[k]);
+			putc('\n', kidto[k]);
+			fflush(kidto[k]);
+			gettimeofday(&kidstart[k], NULL);
+			kidpiece[k] = i;
+			pstat[i] = 1;
+			nbusy++;
+		}
+		if (!nbusy)
+			break;
+		FD_ZERO(&readset);	/* wait for a finished piece */
+		nfd = 0;
+		for (k = 0; k < nkids; k++)
+			if (kidpiece[k] >= 0) {
+				FD_SET(kidpr[k].r, &readset);
+				if (kidpr[k].r >= nfd)
+					nfd = kidpr[k].r + 1;
+			}
+		if (select(nfd, &readset, NULL, NULL, NULL) < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr, "%s: select call failed: %s\n",
+					progname, strerror(errno));
+			exit(cleanup(1));
+		}
+		for (k = 0; k < nkids; k++) {
+			if (kidpiece[k] < 0 || !FD_ISSET(kidpr[k].r, &readset))
+				continue;
+			i = kidpiece[k];
+			x = i / vmult; y = i % vmult;
+			getpiece(kidfrom[k], x, y);
+			gettimeofday(&tnow, NULL);
+			ptime[i] = (tnow.tv_sec - kidstart[k].tv_sec) +
+				1e-6*(tnow.tv_usec - kidstart[k].tv_usec);
+			pstat[i] = 2;
+			kidpiece[k] = -1;
+			nbusy--;
+						/* copy into picture */
+			pp = picture + ((long)(vmult-1-y)*vres*hmult + x)*hres;
+			for (j = 0; j < vres; j++, pp += hres*hmult)
+				memcpy(pp, pbuf + j*hres, hres*sizeof(COLR));
+			if (verbose) {
+				printf("%d %d done\n", x, y);
+				fflush(stdout);
+			}
+		}
+	}
+	for (k = 0; k < nkids; k++) {	/* done with rpict processes */
+		fclose(kidto[k]);
+		fclose(kidfrom[k]);
+		kidpr[k].flags &= ~PF_RUNNING;
+	}
+	rstat = close_processes(kidpr, nkids);
+	if (rstat && rstat != -1)
+		exit(cleanup(rstat));
+					/* write picture in one go */
+	if (lseek(outfd, (off_t)scanorig, SEEK_SET) < 0)
+		filerr("seek");
+	if (writebuf(outfd, (char *)picture, (long)hres*hmult*vres*vmult*
+			sizeof(COLR)) != (long)hres*hmult*vres*vmult*sizeof(COLR))
+		filerr("write");
+	if (syncfp != NULL) {		/* record finished pieces for -R */
+		sflock(F_WRLCK);
+		rewind(syncfp);
+		fprintf(syncfp, "%4d %4d\n%4d %4d\n\n", hmult, vmult, 0, 0);
+		for (i = 0; i < hmult*vmult; i++)
+			if (pstat[i] == 2)
+				fprintf(syncfp, "%4d %4d\n", i/vmult, i%vmult);
+		if (fflush(syncfp) == EOF || ftruncate(fileno(syncfp),
+				(off_t)ftell(syncfp)) < 0) {
+			fprintf(stderr, "%s: cannot write sync file\n",
+					progname);
+			exit(cleanup(1));
+		}
+		sflock(F_UNLCK);
+	}
+	free(picture);
+	free(ptime);
+	free(pstat);
+}
+
+
 static void
 filerr(			/* report file error and exit */
 	char  *t
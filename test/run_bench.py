@@ -0,0 +1,366 @@
+#!/usr/bin/env python
+from __future__ import division, print_function, unicode_literals
+
+''' run_bench.py - Time Radiance renderings of the test/renders scenes
+
+Invocation:
+  As script, call with -H for instructions.
+  As module, see docstrings in class RadianceBench for instructions.
+
+Each benchmark builds its inputs once, then runs a timed command with
+fixed random seeds (-u-) and a fixed process count.  Results are written
+as JSON in the following form, and may be compared against a baseline
+written by an earlier run:
+
+  {
+    "schema": "radiance-bench/1",
+    "date": "2020-04-01T12:00:00",
+    "host": "name",
+    "nproc": 2,
+    "res": 128,
+    "version": "RADIANCE 5.2 ...",
+    "results": {
+      "<bench>": {
+        "wall_s":      elapsed seconds (best of repeats),
+        "cpu_s":       user+system seconds of all processes,
+        "max_rss_kb":  peak resident set size of largest process,
+        "nrays":       rays traced (rpict reports only),
+        "rays_per_s":  nrays / wall_s,
+        "records":     input records processed (rtrace only),
+        "records_per_s": records / wall_s,
+        "amb_values":  values in ambient file afterwards,
+        "status":      "ok", "skipped" or "failed"
+      }, ...
+    },
+    "tolerances": { "<metric>": fraction, ... }   (optional)
+  }
+
+Metrics that are missing or null are not compared.  Tolerances are
+fractional changes allowed in the worse direction before a result is
+reported as a regression; counts such as nrays and amb_values are
+checked in both directions, since a change there means the work done
+has changed.  Tolerances stored in the baseline override the defaults,
+and -t options override both.
+'''
+__all__ = ['BENCHES', 'TOLERANCES', 'RadianceBench', 'main']
+import os
+import re
+import sys
+import json
+import time
+import socket
+import argparse
+import subprocess
+
+SHORTPROGN = os.path.splitext(os.path.basename(sys.argv[0]))[0]
+SCHEMA = 'radiance-bench/1'
+
+# Allowed fractional change of each metric, and whether larger is worse
+# (+1), smaller is worse (-1), or either direction counts (0).
+TOLERANCES = {
+	'wall_s':		(0.25, +1),
+	'cpu_s':		(0.25, +1),
+	'max_rss_kb':	(0.20, +1),
+	'rays_per_s':	(0.20, -1),
+	'records_per_s':	(0.20, -1),
+	'nrays':		(0.02, 0),
+	'amb_values':	(0.10, 0),
+}
+
+# Benchmark scenes, run in test/renders.  Commands are formatted with
+# {res} (image size), {nproc} (process count) and {name} (benchmark).
+# A benchmark is skipped if a file it needs or a program is missing.
+RENDER = '@render.opt -u- -ss 4 -ab 1 -aa .1 -ad 256 -as 64'
+MIXTEX = ('basic.mat mixtex.mat sunset_sky.rad glass_pane.rad'
+		' diorama_walls.rad rect_opening.rad front_cap.rad disks.rad'
+		' constellation.rad blinds.rad')
+BENCHES = (
+	dict(name='inst',
+		setup=['rad -v 0 inst.rif'],
+		run='rpict -t 3600 -vf inside.vf ' + RENDER +
+			' -af {name}_bench.amb -x {res} -y {res} -ps 1'
+			' inst.oct > {name}_bench.unf',
+		amb='{name}_bench.amb'),
+	dict(name='inst_rtrace',
+		setup=['rad -v 0 inst.rif'],
+		run='vwrays -ff -vf fish.vf -x {res} -y {res}'
+			' | rtrace -n {nproc} ' + RENDER + ' -af {name}_bench.amb'
+			' -ffc -x {res} -y {res} inst.oct > {name}_bench.unf',
+		records='{res}*{res}', amb='{name}_bench.amb'),
+	dict(name='mesh',
+		setup=['rad -v 0 mesh.rif'],
+		run='rpict -t 3600 -vf inside.vf ' + RENDER +
+			' -af {name}_bench.amb -x {res} -y {res} -ps 1'
+			' mesh.oct > {name}_bench.unf',
+		amb='{name}_bench.amb'),
+	dict(name='combined', needs=['vase.rtm'],
+		setup=['rad -v 0 combined.rif'],
+		run='rpict -t 3600 -vp 23.5757 8.58098 5.24274'
+			' -vd -12.2856 0.909548 0.48623 -vh 50 -vv 32'
+			' @render.opt -u- -ss 4 -aa 0 -ad 64 -as 0 -ab 1'
+			' -lr -6 -lw 1e-5 -x {res} -y {res} -ps 1'
+			' combined.oct > {name}_bench.unf'),
+	dict(name='mirror_rtrace', needs=['sunset.hdr'],
+		setup=['rad -v 0 mirror.rif'],
+		run='vwrays -ff -vf fish.vf -x {res} -y {res}'
+			' | rtrace -n {nproc} ' + RENDER + ' -ffc -x {res} -y {res}'
+			' mirror.oct > {name}_bench.unf',
+		records='{res}*{res}'),
+	dict(name='blinds_mkpmap', needs=['sunset.hdr', 'blinds20c.xml'],
+		setup=['oconv ' + MIXTEX + ' > {name}_bench.oct'],
+		run='mkpmap -apr 1 -apo m_blinds20c_f -fo+'
+			' -apg {name}_bench.gpm 100k -apc {name}_bench.cpm 1M'
+			' {name}_bench.oct'),
+	dict(name='blinds_rtrace', needs=['sunset.hdr', 'blinds20c.xml'],
+		setup=['oconv ' + MIXTEX + ' > {name}_bench.oct'],
+		run='vwrays -ff -vf fish.vf -x {res} -y {res}'
+			' | rtrace -n {nproc} ' + RENDER + ' -af {name}_bench.amb'
+			' -ffc -x {res} -y {res} {name}_bench.oct > {name}_bench.unf',
+		records='{res}*{res}', amb='{name}_bench.amb'),
+	dict(name='rfluxmtx',
+		run='rfluxmtx -u- -c {res} -ab 2 -lw 1e-4 mirror.rad dummysky.rad'
+			' basic.mat diorama_walls.rad closed_end.rad front_cap.rad'
+			' glass_pane.rad antimatter_portal.rad > {name}_bench.mtx'),
+)
+
+class Error(Exception): pass
+
+def count_ambient(ambfile):
+	'''Return the number of values in an ambient file, or None'''
+	try:
+		out = subprocess.check_output(['lookamb', '-h', '-d', ambfile])
+	except (OSError, subprocess.CalledProcessError):
+		return None
+	return len(out.splitlines())	# one line per value
+
+def run_timed(cmd):
+	'''Run a shell command, returning (exit, wall, cpu, maxrss, stderr)'''
+	start = time.time()
+	proc = subprocess.Popen(cmd, shell=True, stderr=subprocess.PIPE)
+	if hasattr(os, 'wait4'):	# gives usage of this command alone
+		errtxt = proc.stderr.read()
+		pid, status, ru = os.wait4(proc.pid, 0)
+		status = (os.WEXITSTATUS(status) if os.WIFEXITED(status)
+				else -os.WTERMSIG(status))
+		wall = time.time() - start
+		cpu = ru.ru_utime + ru.ru_stime
+		maxrss = ru.ru_maxrss
+		if sys.platform == 'darwin':
+			maxrss //= 1024		# reported in bytes
+	else:
+		errtxt = proc.communicate()[1]
+		status = proc.returncode
+		wall = time.time() - start
+		cpu = maxrss = None
+	return status, wall, cpu, maxrss, errtxt.decode('ascii', 'replace')
+
+class RadianceBench():
+	'''Run benchmarks below subdirectory "renders" and compare results.
+
+	  bindir   - list of paths added to PATH
+	  radlib   - list of paths added to RAYPATH
+	  bench    - list of benchmark names to run (else all)
+	  nproc    - process count for multi-process commands
+	  res      - image size in pixels
+	  repeat   - number of timed runs to take the best of
+	  output   - file to write JSON results to
+	  baseline - JSON results to compare against
+	  tol      - list of "metric=fraction" tolerance overrides
+	'''
+	def __init__(self, **args):
+		self.bindir = args.get('bindir')
+		self.radlib = args.get('radlib')
+		self.benches = args.get('bench')
+		self.nproc = args.get('nproc') or 2
+		self.res = args.get('res') or 128
+		self.repeat = args.get('repeat') or 1
+		self.V = args.get('V')
+		thisdir = os.path.split(os.path.abspath(__file__))[0]
+		self.workdir = os.path.join(thisdir, 'renders')
+		self.tolerances = dict(TOLERANCES)
+		baseline = args.get('baseline')
+		self.baseline = None
+		if baseline:
+			with open(baseline) as f:
+				self.baseline = json.load(f)
+			if self.baseline.get('schema') != SCHEMA:
+				raise Error('Baseline "%s" is not %s' % (baseline, SCHEMA))
+			self._set_tolerances(self.baseline.get('tolerances', {}))
+		for t in args.get('tol') or []:
+			m, v = t.split('=', 1)
+			self._set_tolerances({m: float(v)})
+		self._set_paths()
+		self.results = self._run_all()
+		output = args.get('output')
+		if output:
+			with open(output, 'w') as f:
+				json.dump(self.results, f, indent=2, sort_keys=True)
+				f.write('\n')
+		self.regressions = self._compare() if self.baseline else []
+
+	def _set_tolerances(self, tols):
+		for m, v in tols.items():
+			if m not in TOLERANCES:
+				raise Error('Unknown metric "%s"' % m)
+			self.tolerances[m] = (float(v), TOLERANCES[m][1])
+
+	def _set_paths(self):
+		pathlist = os.environ.get('PATH', '').split(os.pathsep)
+		for bdir in self.bindir or []:
+			pathlist.insert(0, os.path.abspath(bdir))
+		os.environ['PATH'] = os.pathsep.join(pathlist)
+		raypathlist = os.environ.get('RAYPATH', '').split(os.pathsep)
+		for rlib in (self.radlib or []):
+			raypathlist.insert(0, os.path.abspath(rlib))
+		os.environ['RAYPATH'] = os.pathsep.join(['.'] + raypathlist)
+
+	def _run_all(self):
+		try:
+			version = subprocess.check_output(['rtrace', '-version'])
+			version = version.decode('ascii', 'replace').strip()
+		except (OSError, subprocess.CalledProcessError):
+			version = None
+		res = dict(schema=SCHEMA, host=socket.gethostname(),
+			date=time.strftime('%Y-%m-%dT%H:%M:%S'), nproc=self.nproc,
+			res=self.res, version=version, results={})
+		for b in BENCHES:
+			if self.benches and b['name'] not in self.benches:
+				continue
+			r = self._run_one(b)
+			res['results'][b['name']] = r
+			print('%-16s %s' % (b['name'], ' '.join('%s=%s' % (k, r[k])
+					for k in sorted(r) if r[k] is not None)),
+					file=sys.stderr)
+		return res
+
+	def _run_one(self, b):
+		fmt = dict(name=b['name'], res=self.res, nproc=self.nproc)
+		r = dict(status='ok', wall_s=None, cpu_s=None, max_rss_kb=None,
+			nrays=None, rays_per_s=None, records=None,
+			records_per_s=None, amb_values=None)
+		for f in b.get('needs', []):
+			if not os.path.exists(os.path.join(self.workdir, f)):
+				r['status'] = 'skipped'
+				return r
+		cwd = os.getcwd()
+		os.chdir(self.workdir)
+		try:
+			for cmd in b.get('setup', []):
+				cmd = cmd.format(**fmt)
+				if self.V:
+					print(cmd, file=sys.stderr)
+				if subprocess.call(cmd, shell=True):
+					r['status'] = 'skipped'	# missing input?
+					return r
+			cmd = b['run'].format(**fmt)
+			for i in range(self.repeat):
+				if 'amb' in b and os.path.exists(b['amb'].format(**fmt)):
+					os.remove(b['amb'].format(**fmt))
+				if self.V:
+					print(cmd, file=sys.stderr)
+				status, wall, cpu, maxrss, errtxt = run_timed(cmd)
+				if status == 127:
+					r['status'] = 'skipped'	# no such program
+					return r
+				if status:
+					sys.stderr.write(errtxt)
+					r['status'] = 'failed'
+					return r
+				if r['wall_s'] is None or wall < r['wall_s']:
+					r['wall_s'] = round(wall, 3)
+				if cpu is not None and (r['cpu_s'] is None or
+						cpu < r['cpu_s']):
+					r['cpu_s'] = round(cpu, 3)
+				if maxrss is not None:
+					r['max_rss_kb'] = max(maxrss, r['max_rss_kb'] or 0)
+				nr = re.findall(r'(\d+) rays,', errtxt)
+				if nr:
+					r['nrays'] = int(nr[-1])
+			if r['nrays'] is not None:
+				r['rays_per_s'] = round(r['nrays'] / r['wall_s'], 1)
+			if 'records' in b:
+				r['records'] = eval(b['records'].format(**fmt))
+				r['records_per_s'] = round(r['records'] / r['wall_s'], 1)
+			if 'amb' in b:
+				r['amb_values'] = count_ambient(b['amb'].format(**fmt))
+		finally:
+			os.chdir(cwd)
+		return r
+
+	def _compare(self):
+		'''Return list of regressions against the baseline, printing all'''
+		base = self.baseline
+		regressions = []
+		for key in ('nproc', 'res'):
+			if base.get(key) != self.results[key]:
+				print('Warning: baseline %s=%s, this run %s=%s' % (key,
+						base.get(key), key, self.results[key]),
+						file=sys.stderr)
+		for name, r in sorted(self.results['results'].items()):
+			b = base['results'].get(name)
+			if b is None or (r['status'], b.get('status')) != ('ok', 'ok'):
+				continue
+			for m, (tol, sense) in sorted(self.tolerances.items()):
+				if r.get(m) is None or not b.get(m):
+					continue
+				change = (r[m] - b[m]) / b[m]
+				bad = (change > tol if sense > 0 else
+						-change > tol if sense < 0 else
+						abs(change) > tol)
+				if bad:
+					regressions.append((name, m, b[m], r[m]))
+				if bad or self.V:
+					print('%-16s %-14s %12g -> %-12g %+6.1f%%%s' % (name,
+							m, b[m], r[m], 100.*change,
+							'  REGRESSION' if bad else ''),
+							file=sys.stderr)
+		return regressions
+
+
+def main():
+	'''Main function for invocation as script. See usage instructions with -H'''
+	parser = argparse.ArgumentParser(add_help=False,
+		description='Run Radiance rendering benchmarks')
+	parser.add_argument('-V', action='store_true',
+		help='Verbose: Print all commands and comparisons to stderr')
+	parser.add_argument('-H', action='help',
+		help='Help: print this text to stderr and exit')
+	parser.add_argument('-p', action='store', nargs=1,
+		dest='bindir', metavar='bindir', help='Path to Radiance binaries')
+	parser.add_argument('-l', action='store', nargs=1,
+		dest='radlib', metavar='radlib', help='Path to Radiance library')
+	parser.add_argument('-c', action='append',
+		dest='bench', metavar='bench', help='Benchmark to run (else all)')
+	parser.add_argument('-n', action='store', type=int,
+		dest='nproc', metavar='nproc', help='Number of processes (2)')
+	parser.add_argument('-x', action='store', type=int,
+		dest='res', metavar='res', help='Image size in pixels (128)')
+	parser.add_argument('-r', action='store', type=int,
+		dest='repeat', metavar='repeat', help='Timed runs per benchmark (1)')
+	parser.add_argument('-o', action='store',
+		dest='output', metavar='results', help='Write JSON results here')
+	parser.add_argument('-b', action='store',
+		dest='baseline', metavar='baseline', help='Compare to JSON results')
+	parser.add_argument('-t', action='append',
+		dest='tol', metavar='metric=frac', help='Override a tolerance')
+	args = parser.parse_args()
+	bench = RadianceBench(**vars(args))
+	failed = [n for n, r in bench.results['results'].items()
+			if r['status'] == 'failed']
+	if failed:
+		raise Error('Failed: ' + ' '.join(sorted(failed)))
+	if bench.regressions:
+		raise Error('%d regression(s) against baseline'
+				% len(bench.regressions))
+
+
+if __name__ == '__main__':
+	try: main()
+	except KeyboardInterrupt:
+		sys.stderr.write('*cancelled*\n')
+		exit(1)
+	except Error as e:
+		sys.stderr.write('%s: %s\n' % (SHORTPROGN, str(e)))
+		exit(1)
+
+# vi: set ts=4 sw=4 :